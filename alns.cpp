@@ -0,0 +1,533 @@
+#include "alns.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+#include "rng.hpp"
+#include "routes.hpp"
+
+namespace {
+
+// Inserting a customer right after node `after` of route r (the front
+// when after is 0) adds cost.
+struct slot {
+  int r;
+  int after;
+  double cost;
+};
+
+// Index drawn with probability proportional to its weight.
+int roulette(const std::vector<double> &w, rng &g) {
+  double target = g.uniform() * std::accumulate(w.begin(), w.end(), 0.0);
+  for (size_t k = 0; k + 1 < w.size(); ++k) {
+    target -= w[k];
+    if (target < 0) {
+      return k;
+    }
+  }
+  return w.size() - 1;
+}
+
+// The destroy and repair operators over the routes of one search. Route
+// costs and loads are kept up to date on rt, so that rolling it back
+// undoes an iteration completely.
+class ruin_recreate {
+public:
+  ruin_recreate(const sol &s, const nbr_list &nbrs, routes &rt, rng &g)
+      : nodes_(s.nodes_), d_(s.dist_mtx_), nbrs_(nbrs),
+        capacity_(s.capacity_), rt_(rt), g_(g) {}
+
+  // Takes the given routed customers out; returns the change of the total
+  // cost.
+  double destroy(const std::vector<int> &customers) {
+    removed_.clear();
+    double delta = 0;
+    for (const int c : customers) {
+      delta += take(c);
+    }
+    return delta;
+  }
+
+  // Takes about q customers out; returns the change of the total cost.
+  double destroy(const int kind, const int q) {
+    removed_.clear();
+    double delta = 0;
+    switch (kind) {
+    case ds_random:
+      while (static_cast<int>(removed_.size()) < q) {
+        const int c = random_routed();
+        delta += take(c);
+      }
+      break;
+    case ds_worst:
+      delta += destroy_worst(q);
+      break;
+    case ds_related:
+      delta += destroy_related(q);
+      break;
+    default:
+      // whole routes until q customers are out
+      while (static_cast<int>(removed_.size()) < q) {
+        const int r = rt_.route(random_routed());
+        while (rt_.head(r) != 0) {
+          delta += take(rt_.head(r));
+        }
+      }
+    }
+    return delta;
+  }
+
+  // Puts the removed customers back, k = 1 for greedy insertion and the
+  // regret degree otherwise; adds the change of the total cost to delta.
+  // False when some customer fits nowhere.
+  bool repair(const int k, double &delta) {
+    find_empty();
+    opts_.resize(removed_.size());
+    for (size_t i = 0; i < removed_.size(); ++i) {
+      build(i);
+    }
+    while (!removed_.empty()) {
+      size_t pick = 0;
+      slot where{-1, 0, 0};
+      double best_key = std::numeric_limits<double>::max();
+      double best_first = std::numeric_limits<double>::max();
+      for (size_t i = 0; i < removed_.size(); ++i) {
+        slot first{-1, 0, 0};
+        double key = 0;
+        if (opts_[i].empty()) {
+          first = scan_all(removed_[i]);
+          if (first.r < 0) {
+            return false;
+          }
+          // a single option: as urgent as it gets for regret
+          key = k > 1 ? -big * (k - 1) : first.cost;
+        } else {
+          key = rank(opts_[i], k, first);
+        }
+        if (key < best_key || (key == best_key && first.cost < best_first)) {
+          best_key = key;
+          best_first = first.cost;
+          pick = i;
+          where = first;
+        }
+      }
+      const int c = removed_[pick];
+      delta += put(c, where);
+      removed_[pick] = removed_.back();
+      removed_.pop_back();
+      opts_[pick] = std::move(opts_.back());
+      opts_.pop_back();
+      // only the changed route is evaluated again; when it was the spare
+      // empty route, refresh replaces its empty-route options with those
+      // next to c, and the next empty route (if any) is offered instead
+      const bool opened = where.r == empty_;
+      if (opened) {
+        find_empty();
+      }
+      for (size_t i = 0; i < removed_.size(); ++i) {
+        refresh(i, where.r);
+        if (opened) {
+          add_empty(i);
+        }
+      }
+    }
+    return true;
+  }
+
+private:
+  // Penalty standing in for a missing option when computing regrets.
+  static constexpr double big = 1e12;
+
+  int random_routed() {
+    const int n = nodes_.size();
+    while (true) {
+      const int c = 1 + g_.below(n - 1);
+      if (rt_.route(c) >= 0) {
+        return c;
+      }
+    }
+  }
+
+  double take(const int c) {
+    const int r = rt_.route(c);
+    const int p = rt_.prev(c);
+    const int n = rt_.next(c);
+    const double gain = d_(p, n) - d_(p, c) - d_(c, n);
+    rt_.add_cost(r, gain);
+    rt_.add_load(r, nodes_[c].demand_);
+    rt_.remove(c);
+    removed_.push_back(c);
+    return gain;
+  }
+
+  double put(const int c, const slot &s) {
+    const int b = s.after != 0 ? rt_.next(s.after) : rt_.head(s.r);
+    const double cost = d_(s.after, c) + d_(c, b) - d_(s.after, b);
+    rt_.insert(c, s.r, s.after);
+    rt_.add_cost(s.r, cost);
+    rt_.add_load(s.r, -nodes_[c].demand_);
+    return cost;
+  }
+
+  // Removal savings are taken once, before any removal, and q customers
+  // drawn among the 5q largest, biased towards the top.
+  double destroy_worst(const int q) {
+    const int n = nodes_.size();
+    saving_.clear();
+    for (int c = 1; c < n; ++c) {
+      if (rt_.route(c) < 0) {
+        continue;
+      }
+      const int p = rt_.prev(c);
+      const int nx = rt_.next(c);
+      saving_.emplace_back(d_(p, c) + d_(c, nx) - d_(p, nx), c);
+    }
+    const size_t m = std::min(saving_.size(), static_cast<size_t>(5) * q);
+    std::partial_sort(saving_.begin(), saving_.begin() + m, saving_.end(),
+                      std::greater<>());
+    saving_.resize(m);
+    double delta = 0;
+    while (static_cast<int>(removed_.size()) < q && !saving_.empty()) {
+      const double y = g_.uniform();
+      const size_t i = static_cast<size_t>(y * y * y * saving_.size());
+      delta += take(saving_[i].second);
+      saving_.erase(saving_.begin() + i);
+    }
+    return delta;
+  }
+
+  // Shaw removal over the candidate lists: the next customer is drawn,
+  // biased towards the most related, among the neighbours of one already
+  // removed. Relatedness adds distance (scaled by the farthest candidate)
+  // and demand difference (scaled by the capacity).
+  double destroy_related(const int q) {
+    double delta = take(random_routed());
+    while (static_cast<int>(removed_.size()) < q) {
+      const int r = removed_[g_.below(removed_.size())];
+      const int *row = nbrs_.of(r);
+      related_.clear();
+      double scale = 0;
+      for (int k = 0; k < nbrs_.k(); ++k) {
+        const int j = row[k];
+        if (j != 0 && rt_.route(j) >= 0) {
+          related_.emplace_back(d_(r, j), j);
+          scale = std::max(scale, d_(r, j));
+        }
+      }
+      if (related_.empty()) {
+        delta += take(random_routed());
+        continue;
+      }
+      scale = std::max(scale, 1e-9);
+      for (auto &[rel, j] : related_) {
+        rel = rel / scale +
+              std::abs(nodes_[r].demand_ - nodes_[j].demand_) /
+                  static_cast<double>(std::max(capacity_, 1));
+      }
+      std::sort(related_.begin(), related_.end());
+      const double y = g_.uniform();
+      const double y3 = y * y * y;
+      delta += take(related_[static_cast<size_t>(y3 * y3 * related_.size())]
+                        .second);
+    }
+    return delta;
+  }
+
+  void find_empty() {
+    empty_ = -1;
+    for (int r = 0; r < rt_.n_routes(); ++r) {
+      if (rt_.size(r) == 0) {
+        empty_ = r;
+        return;
+      }
+    }
+  }
+
+  // Keeps the cheaper of s and the option already held for route s.r.
+  static void offer(std::vector<slot> &opts, const slot &s) {
+    for (auto &o : opts) {
+      if (o.r == s.r) {
+        if (s.cost < o.cost) {
+          o = s;
+        }
+        return;
+      }
+    }
+    opts.push_back(s);
+  }
+
+  // Options of customer c next to its neighbours in route only_r, or in
+  // any route when only_r is -1.
+  void near(const int c, const int only_r, std::vector<slot> &opts) const {
+    const int *row = nbrs_.of(c);
+    const int dem = nodes_[c].demand_;
+    for (int k = 0; k < nbrs_.k(); ++k) {
+      const int m = row[k];
+      if (m == 0) {
+        continue;
+      }
+      const int r = rt_.route(m);
+      if (r < 0 || (only_r >= 0 && r != only_r) || rt_.load(r) < dem) {
+        continue;
+      }
+      for (const int a : {rt_.prev(m), m}) {
+        const int b = a != 0 ? rt_.next(a) : rt_.head(r);
+        offer(opts, {r, a, d_(a, c) + d_(c, b) - d_(a, b)});
+      }
+    }
+  }
+
+  void add_empty(const size_t i) {
+    const int c = removed_[i];
+    if (empty_ >= 0 && nodes_[c].demand_ <= capacity_) {
+      opts_[i].push_back({empty_, 0, 2 * d_(0, c)});
+    }
+  }
+
+  void drop(const size_t i, const int r) {
+    auto &opts = opts_[i];
+    opts.erase(std::remove_if(opts.begin(), opts.end(),
+                              [r](const slot &s) { return s.r == r; }),
+               opts.end());
+  }
+
+  void build(const size_t i) {
+    opts_[i].clear();
+    near(removed_[i], -1, opts_[i]);
+    add_empty(i);
+  }
+
+  void refresh(const size_t i, const int r) {
+    drop(i, r);
+    near(removed_[i], r, opts_[i]);
+  }
+
+  // Cheapest feasible insertion of c over every position of every route,
+  // r = -1 if there is none.
+  slot scan_all(const int c) const {
+    slot best{-1, 0, std::numeric_limits<double>::max()};
+    const int dem = nodes_[c].demand_;
+    for (int r = 0; r < rt_.n_routes(); ++r) {
+      if (rt_.load(r) < dem) {
+        continue;
+      }
+      for (int a = 0;;) {
+        const int b = a != 0 ? rt_.next(a) : rt_.head(r);
+        const double cost = d_(a, c) + d_(c, b) - d_(a, b);
+        if (cost < best.cost) {
+          best = {r, a, cost};
+        }
+        if (b == 0) {
+          break;
+        }
+        a = b;
+      }
+    }
+    return best;
+  }
+
+  // Sort key of a customer, lowest first: its cheapest insertion for
+  // greedy (k = 1), minus its regret over the k best routes otherwise.
+  // Sets first to the cheapest option.
+  static double rank(const std::vector<slot> &opts, const int k,
+                     slot &first) {
+    const double none = std::numeric_limits<double>::max();
+    double cheapest[3] = {none, none, none};
+    for (const auto &o : opts) {
+      if (o.cost < cheapest[0]) {
+        first = o;
+      }
+      for (int h = 0; h < k; ++h) {
+        if (o.cost < cheapest[h]) {
+          std::copy_backward(cheapest + h, cheapest + k - 1, cheapest + k);
+          cheapest[h] = o.cost;
+          break;
+        }
+      }
+    }
+    if (k == 1) {
+      return cheapest[0];
+    }
+    double regret = 0;
+    for (int h = 1; h < k; ++h) {
+      regret += (cheapest[h] < none ? cheapest[h] : big) - cheapest[0];
+    }
+    return -regret;
+  }
+
+  const node_table &nodes_;
+  const dist_mtx &d_;
+  const nbr_list &nbrs_;
+  const int capacity_;
+  routes &rt_;
+  rng &g_;
+  std::vector<int> removed_;
+  // insertion options of removed_[i], at most one per route
+  std::vector<std::vector<slot>> opts_;
+  // an empty route, -1 if none
+  int empty_ = -1;
+  std::vector<std::pair<double, int>> saving_, related_;
+};
+
+double total_cost(const std::vector<veh> &vehicles) {
+  return std::accumulate(
+      std::begin(vehicles), std::end(vehicles), 0.0,
+      [](const double sum, const veh &v) { return sum + v.cost_; });
+}
+
+} // namespace
+
+alns_sol::alns_sol(const sol &start, const alns_params &params)
+    : sol(start), params_(params), nbrs_(nodes_, dist_mtx_, params.n_nbrs) {
+  valid_start_ = check_sol_val();
+}
+
+alns_sol::alns_sol(const prob &p, const alns_params &params)
+    : sol(p), params_(params), nbrs_(nodes_, dist_mtx_, params.n_nbrs) {
+  create_init_sol();
+  valid_start_ = check_sol_val();
+}
+
+void alns_sol::run() {
+  iterations_ = 0;
+  dw_.assign(n_destroy_kinds, 1);
+  rw_.assign(n_repair_kinds, 1);
+  const int n_customers = static_cast<int>(nodes_.size()) - 1;
+  if (n_customers < 2 || !valid_start_) {
+    return;
+  }
+  rng g(params_.seed);
+  routes rt(vehicles_, nodes_);
+  ruin_recreate ops(*this, nbrs_, rt, g);
+  const int max_q = std::clamp(params_.max_remove, 1,
+                               std::max(1, n_customers * 2 / 5));
+  const int min_q = std::clamp(params_.min_remove, 1, max_q);
+
+  double current = total_cost(vehicles_);
+  double best = current;
+  std::vector<veh> best_vehicles = vehicles_;
+  const metropolis accept;
+  double temp = std::max(params_.start_worse * current / std::log(2.0), 1e-9);
+  const double end_temp = temp * params_.end_temp;
+
+  sa_limits limits = params_.limits;
+  if (!limits.anytime()) {
+    limits.iterations = 25000;
+  }
+  const auto start_time = std::chrono::steady_clock::now();
+  // the rate that reaches end_temp as the budget runs out
+  geometric_cooling cooling{1};
+  auto pace = [&]() {
+    double left = std::numeric_limits<double>::max();
+    if (limits.iterations > 0) {
+      left = limits.iterations - iterations_;
+    }
+    if (limits.seconds > 0 && iterations_ > 0) {
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start_time;
+      left = std::min(left, iterations_ / elapsed.count() *
+                                (limits.seconds - elapsed.count()));
+    }
+    cooling.rate = left < std::numeric_limits<double>::max() && temp > end_temp
+                       ? std::pow(end_temp / temp, 1 / std::max(left, 1.0))
+                       : 1;
+  };
+  pace();
+  const long long every = std::max(1, limits.check_every);
+  std::vector<double> d_score(n_destroy_kinds, 0), r_score(n_repair_kinds, 0);
+  std::vector<int> d_used(n_destroy_kinds, 0), r_used(n_repair_kinds, 0);
+
+  while (limits.iterations <= 0 || iterations_ < limits.iterations) {
+    if (limits.seconds > 0 || limits.cancel != nullptr ||
+        (limits.progress && iterations_ % every == 0)) {
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start_time;
+      if (limits.progress && iterations_ % every == 0) {
+        limits.progress({elapsed.count(), iterations_, temp, best});
+      }
+      if ((limits.seconds > 0 && elapsed.count() >= limits.seconds) ||
+          (limits.cancel != nullptr &&
+           limits.cancel->load(std::memory_order_relaxed))) {
+        break;
+      }
+    }
+    ++iterations_;
+    const int q = min_q + g.below(max_q - min_q + 1);
+    const int dk = roulette(dw_, g);
+    const int rk = roulette(rw_, g);
+    double delta = ops.destroy(dk, q);
+    double score = 0;
+    if (!ops.repair(rk == rp_greedy ? 1 : rk == rp_regret2 ? 2 : 3, delta)) {
+      rt.rollback();
+    } else if (current + delta < best - 1e-9) {
+      score = params_.score_best;
+      current += delta;
+      best = current;
+      rt.commit();
+      rt.to_vehicles(best_vehicles);
+    } else if (accept(delta, temp, g)) {
+      score = delta < -1e-9 ? params_.score_better : params_.score_accepted;
+      current += delta;
+      rt.commit();
+    } else {
+      rt.rollback();
+    }
+    temp = cooling(temp);
+
+    d_score[dk] += score;
+    d_used[dk]++;
+    r_score[rk] += score;
+    r_used[rk]++;
+    if (iterations_ % std::max(1, params_.segment) == 0) {
+      auto adapt = [this](std::vector<double> &w, std::vector<double> &score,
+                          std::vector<int> &used) {
+        for (size_t k = 0; k < w.size(); ++k) {
+          if (used[k] > 0) {
+            // floored, so that no operator drops out for good
+            w[k] = std::max(0.1, w[k] * (1 - params_.reaction) +
+                                     params_.reaction * score[k] / used[k]);
+          }
+          score[k] = 0;
+          used[k] = 0;
+        }
+      };
+      adapt(dw_, d_score, d_used);
+      adapt(rw_, r_score, r_used);
+      pace();
+    }
+  }
+  vehicles_ = best_vehicles;
+}
+
+bool alns_sol::reinsert(const std::vector<int> &customers,
+                        const repair_kind kind) {
+  for (const int c : customers) {
+    if (c < 1 || c >= static_cast<int>(nodes_.size()) || !is_routed(c)) {
+      return false;
+    }
+  }
+  rng g(params_.seed);
+  routes rt(vehicles_, nodes_);
+  ruin_recreate ops(*this, nbrs_, rt, g);
+  double delta = ops.destroy(customers);
+  if (!ops.repair(kind == rp_greedy ? 1 : kind == rp_regret2 ? 2 : 3, delta)) {
+    return false;
+  }
+  rt.to_vehicles(vehicles_);
+  return true;
+}
+
+void alns_sol::solve() {
+  if (!valid_start_) {
+    std::cout << "The input solution is invalid." << '\n';
+  }
+  run();
+  std::cout << "Cost: " << total_cost(vehicles_) << '\n';
+  std::cout << "Iterations: " << iterations_ << '\n';
+  std::cout << "Solution valid: " << check_sol_val() << '\n';
+}
@@ -0,0 +1,102 @@
+#ifndef ALNS_HPP
+#define ALNS_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "anneal.hpp"
+#include "neighbors.hpp"
+#include "utils.hpp"
+
+// Destroy operators: which customers an iteration takes out.
+enum destroy_kind {
+  ds_random,  // uniformly at random
+  ds_worst,   // those whose removal saves the most, with some randomness
+  ds_related, // Shaw: close in space and demand to those already taken
+  ds_route,   // every customer of a random route
+  n_destroy_kinds
+};
+
+// Repair operators: how they are put back.
+enum repair_kind {
+  rp_greedy,  // cheapest insertion first
+  rp_regret2, // largest regret over the two best routes first
+  rp_regret3, // ... over the three best routes
+  n_repair_kinds
+};
+
+// Settings of an ALNS run.
+struct alns_params {
+  // customers removed per iteration, at most 40% of them
+  int min_remove = 5;
+  int max_remove = 60;
+  // the start temperature accepts a solution this much (relative) worse
+  // than the initial one with probability 1/2; it cools geometrically to
+  // end_temp times that over the budget (the rate is re-estimated from
+  // the iteration speed every segment under a time budget)
+  double start_worse = 0.01;
+  double end_temp = 0.002;
+  // operator weights are updated every segment iterations, moving
+  // `reaction` of the way to the average score of the segment
+  int segment = 100;
+  double reaction = 0.1;
+  // scores of an iteration: new best, better than current, accepted
+  double score_best = 33;
+  double score_better = 9;
+  double score_accepted = 13;
+  int n_nbrs = 20;
+  uint64_t seed = 1;
+  // 25000 iterations when neither a time nor an iteration budget is set
+  sa_limits limits;
+};
+
+// Adaptive large neighbourhood search (Ropke & Pisinger). Every iteration
+// removes a few customers with a destroy operator and reinserts them with
+// a repair operator, the pair picked by roulette over weights that adapt
+// to how often each operator led to accepted and improving solutions. The
+// result is accepted with the metropolis rule and geometric cooling of
+// anneal.hpp; rejected iterations are rolled back through the routes
+// journal.
+//
+// Insertions are granular: a customer is only tried next to its n_nbrs
+// candidate neighbours, or on an empty route, and all routes are scanned
+// only when none of those fits. The best insertion of every removed
+// customer into every such route is cached, and only the route an
+// insertion changed is evaluated again.
+//
+// An invalid start (customers left unrouted, a capacity broken) is kept
+// as it is: run() does not search from it, and check_sol_val() says so.
+class alns_sol : public sol {
+public:
+  explicit alns_sol(const sol &start, const alns_params &params = alns_params());
+
+  // Starts from sol::create_init_sol.
+  explicit alns_sol(const prob &p, const alns_params &params = alns_params());
+
+  void solve() override;
+
+  // Runs the search and leaves the best solution found in vehicles_,
+  // without printing anything.
+  void run();
+
+  long long iterations() const { return iterations_; }
+
+  // Takes the customers (distinct, routed) out and puts them back with one
+  // repair of the given kind, as an iteration of run() would. False, with
+  // the routes unchanged, when some customer fits nowhere.
+  bool reinsert(const std::vector<int> &customers, repair_kind kind);
+
+  // Weights of the operators at the end of the last run(), by kind.
+  const std::vector<double> &destroy_weights() const { return dw_; }
+
+  const std::vector<double> &repair_weights() const { return rw_; }
+
+private:
+  alns_params params_;
+  nbr_list nbrs_;
+  long long iterations_ = 0;
+  bool valid_start_ = false;
+  std::vector<double> dw_, rw_;
+};
+
+#endif // ALNS_HPP
@@ -0,0 +1,410 @@
+#ifndef ANNEAL_HPP
+#define ANNEAL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "checkpoint.hpp"
+#include "moves.hpp"
+#include "rng.hpp"
+#include "routes.hpp"
+#include "trace.hpp"
+#include "utils.hpp"
+
+// State of a run handed to the progress callback.
+struct sa_progress {
+  double seconds;
+  long long iterations;
+  double temp;
+  double best_cost;
+};
+
+// Anytime limits of a run. With a time or iteration budget the search
+// keeps reheating until the budget is spent instead of stopping after
+// n_reheats; the cancellation token stops it either way. The clock, the
+// token and the callback are looked at once every check_every iterations.
+struct sa_limits {
+  double seconds = 0;       // wall-clock budget, 0 for none
+  long long iterations = 0; // iteration budget, 0 for none
+  // set from any thread to stop the run
+  const std::atomic<bool> *cancel = nullptr;
+  int check_every = 1024;
+  // called from the solving thread at every check (from every worker
+  // thread when shared through ms_sol)
+  std::function<void(const sa_progress &)> progress;
+
+  bool anytime() const { return seconds > 0 || iterations > 0; }
+};
+
+// Policies of the annealer. Each is a small value type whose call operator
+// the compiler inlines into the loop.
+
+// Acceptance: whether a move changing the cost by delta is taken at
+// temperature temp.
+struct metropolis {
+  bool operator()(const double delta, const double temp, rng &g) const {
+    return delta < -1e-10 || g.uniform() < std::exp(-delta / temp);
+  }
+};
+
+// Threshold accepting: any move less than temp worse, no randomness.
+struct threshold_acceptance {
+  bool operator()(const double delta, const double temp, rng &) const {
+    return delta < temp;
+  }
+};
+
+// Cooling: the temperature of the next iteration.
+struct geometric_cooling {
+  double rate;
+
+  double operator()(const double temp) const { return temp * rate; }
+};
+
+// Move operators: propose one move on rt, as the functions of moves.hpp.
+struct mixed_moves {
+  move_mix mix;
+
+  template <typename Ctx, typename Accept>
+  bool operator()(const Ctx &ctx, routes &rt, rng &g, Accept accept,
+                  double &delta) const {
+    return apply_move(mix.pick(g), ctx, rt, g, accept, delta);
+  }
+};
+
+// A single operator, known at compile time.
+template <int Kind> struct single_move {
+  template <typename Ctx, typename Accept>
+  bool operator()(const Ctx &ctx, routes &rt, rng &g, Accept accept,
+                  double &delta) const {
+    if constexpr (Kind == mv_swap) {
+      return swap_move(ctx, rt, g, accept, delta);
+    } else if constexpr (Kind == mv_two_opt) {
+      return two_opt_move(ctx, rt, g, accept, delta);
+    } else if constexpr (Kind == mv_two_opt_star) {
+      return two_opt_star_move(ctx, rt, g, accept, delta);
+    } else if constexpr (Kind == mv_or_opt) {
+      return or_opt_move(ctx, rt, g, accept, delta);
+    } else {
+      return relocate_move(ctx, rt, g, accept, delta);
+    }
+  }
+};
+
+// The best solution of concurrent walks (ms_sol). Its cost is published and
+// read lock-free on every new best; the routes behind it are handed over
+// under the mutex at limit checks and reheats only, so cost may run ahead
+// of routes_cost for up to check_every iterations.
+struct incumbent {
+  std::atomic<double> cost{std::numeric_limits<double>::max()};
+  std::mutex m;
+  std::vector<veh> routes;
+  double routes_cost = std::numeric_limits<double>::max();
+};
+
+// Settings of a run that leave the loop's code alone.
+struct anneal_setup {
+  int stag_limit = 500000; // taken as 1 when smaller
+  double init_temp = 5000;
+  int n_reheats = 20;
+  sa_limits limits;
+  // best shared with concurrent walks, see sa_sol::share_best
+  incumbent *shared_best = nullptr;
+  double restart_gap = 0;
+  std::string trace_path;
+  int trace_every = 1000;
+  // The state is written to checkpoint_path at the first limit check
+  // checkpoint_every iterations after the last one, and when a limit stops
+  // the run.
+  std::string checkpoint_path;
+  long long checkpoint_every = 0;
+  // written to the checkpoint as is, see node_order_hash
+  uint64_t node_order = 0;
+  // carry on from here rather than from the vehicles passed to run()
+  const sa_checkpoint *resume = nullptr;
+};
+
+struct anneal_result {
+  long long iterations = 0;
+  bool stopped = false; // by a limit or the cancellation token
+};
+
+// Simulated annealing with reheats over the routes of vehicles, which it
+// leaves holding the best solution found. Move, Accept and Cooling are the
+// policies above (or anything with the same call operator) and Dist the
+// distance type of the move context, so every configuration compiles into
+// its own loop with nothing called indirectly. sa_sol is
+// annealer<mixed_moves, metropolis, geometric_cooling, dist_view<K>>, with
+// single_move<mv_relocate> for the default relocate-only mix.
+template <typename Move, typename Accept, typename Cooling, typename Dist>
+class annealer {
+public:
+  annealer(Move move, Accept accept, Cooling cooling)
+      : move_(move), accept_(accept), cooling_(cooling) {}
+
+  // Move counters go to ctx.stats, if set, when built with CVRP_TRACE. With
+  // setup.resume, vehicles is replaced by the checkpoint's current routes
+  // and the iteration count goes on from the checkpoint's.
+  anneal_result run(const anneal_setup &setup,
+                    const basic_move_ctx<Dist> &ctx,
+                    std::vector<veh> &vehicles, rng &g) const;
+
+private:
+  Move move_;
+  Accept accept_;
+  Cooling cooling_;
+};
+
+template <typename Move, typename Accept, typename Cooling, typename Dist>
+anneal_result annealer<Move, Accept, Cooling, Dist>::run(
+    const anneal_setup &setup, const basic_move_ctx<Dist> &ctx,
+    std::vector<veh> &vehicles, rng &g) const {
+  long long iterations = 0;
+  bool stopped = false;
+  const sa_limits &limits = setup.limits;
+  incumbent *const shared = setup.shared_best;
+  const sa_checkpoint *resume = setup.resume;
+  if (resume) {
+    vehicles = resume->current;
+    iterations = resume->iterations;
+    g.set_state(resume->rng_state);
+  }
+  const double cost = std::accumulate(
+      std::begin(vehicles), std::end(vehicles), 0.0,
+      [](const double sum, const veh &v) { return sum + v.cost_; });
+  // counted into a local when the context has no stats
+  CVRP_TRACE_ON(search_stats own_stats;)
+  CVRP_TRACE_ON(search_stats *const stats = ctx.stats;)
+  // the per-iteration counter stays in a register, see the end
+  // the counters cover this run only, a resumed one included
+  CVRP_TRACE_ON(search_stats &counts = stats ? *stats : own_stats;
+                counts.reheat_best.push_back(cost); long long metropolis = 0;
+                const long long first_iteration = iterations;
+                search_trace trace(setup.trace_path.empty()
+                                       ? 0
+                                       : setup.trace_every);)
+  double best_cost = resume ? resume->best_cost : cost;
+  double current_cost = resume ? resume->cost : cost;
+  const int n_nodes = ctx.nodes.size();
+  // a reheat must make at least one iteration, or an anytime run would
+  // never reach a limit check
+  const int stag_limit = std::max(1, setup.stag_limit);
+  // The best state is rt as of its last commit(); moves since then sit in
+  // rt's journal. It is copied out only when a reheat starts, or when the
+  // journal outgrows a few copies of the state.
+  routes rt(vehicles, ctx.nodes);
+  routes best = resume ? routes(resume->best, ctx.nodes) : routes();
+  bool best_in_rt = !resume;
+  const size_t max_journal = 4 * static_cast<size_t>(n_nodes) + 1024;
+  auto save_best = [&]() {
+    if (best_in_rt) {
+      routes live = rt;
+      rt.rollback();
+      best = std::move(rt);
+      rt = std::move(live);
+      best_in_rt = false;
+    }
+    rt.commit();
+  };
+  // the routes of the best state, wherever it is
+  auto best_vehicles = [&]() {
+    std::vector<veh> out = vehicles;
+    if (best_in_rt) {
+      routes last = rt;
+      last.rollback();
+      last.to_vehicles(out);
+    } else {
+      best.to_vehicles(out);
+    }
+    return out;
+  };
+  auto publish = [shared](const double c) {
+    double seen = shared->cost.load(std::memory_order_relaxed);
+    while (c < seen && !shared->cost.compare_exchange_weak(
+                           seen, c, std::memory_order_relaxed)) {
+    }
+  };
+  // The routes go to the incumbent when this walk's best beats them.
+  double offered = std::numeric_limits<double>::max();
+  auto offer = [&]() {
+    if (best_cost >= offered) {
+      return;
+    }
+    offered = best_cost;
+    if (best_cost > shared->cost.load(std::memory_order_relaxed)) {
+      return; // beaten already, whoever holds it offers their own
+    }
+    std::vector<veh> mine = best_vehicles();
+    const std::lock_guard<std::mutex> lock(shared->m);
+    if (best_cost < shared->routes_cost) {
+      shared->routes = std::move(mine);
+      shared->routes_cost = best_cost;
+    }
+  };
+  // A walk whose best since its last restart lags the shared best by more
+  // than restart_gap carries on from the incumbent's routes.
+  double walk_best = cost;
+  auto restart_if_behind = [&]() {
+    if (walk_best <= shared->cost.load(std::memory_order_relaxed) *
+                         (1 + setup.restart_gap)) {
+      return;
+    }
+    std::vector<veh> from;
+    double from_cost = 0;
+    {
+      const std::lock_guard<std::mutex> lock(shared->m);
+      if (shared->routes_cost >= walk_best) {
+        return;
+      }
+      from = shared->routes;
+      from_cost = shared->routes_cost;
+    }
+    save_best();
+    rt = routes(from, ctx.nodes);
+    current_cost = from_cost;
+    walk_best = from_cost;
+    if (from_cost < best_cost) {
+      best_cost = from_cost;
+      best_in_rt = true;
+    }
+  };
+  if (shared) {
+    publish(best_cost);
+    offer();
+  }
+
+  // Limits are looked at when iterations reaches next_check, so an
+  // unlimited run pays a single compare per iteration.
+  const auto start_time = std::chrono::steady_clock::now();
+  const bool checkpointed = !setup.checkpoint_path.empty();
+  const bool checked = limits.anytime() || limits.cancel != nullptr ||
+                       limits.progress != nullptr || checkpointed ||
+                       shared != nullptr;
+  const long long every = std::max(1, limits.check_every);
+  auto next_check_after = [&](const long long it) {
+    long long next = it + every;
+    if (limits.iterations > 0) {
+      next = std::min(next, limits.iterations);
+    }
+    return next;
+  };
+  long long next_check = checked ? next_check_after(iterations)
+                                 : std::numeric_limits<long long>::max();
+  auto check_limits = [&](const double temp) {
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start_time;
+    if (limits.progress) {
+      limits.progress({elapsed.count(), iterations, temp, best_cost});
+    }
+    stopped = (limits.seconds > 0 && elapsed.count() >= limits.seconds) ||
+              (limits.iterations > 0 && iterations >= limits.iterations) ||
+              (limits.cancel != nullptr &&
+               limits.cancel->load(std::memory_order_relaxed));
+    next_check = next_check_after(iterations);
+  };
+  long long next_checkpoint = iterations + setup.checkpoint_every;
+  // called at a check, before the iteration the loop is about to make
+  auto checkpoint = [&](const int reheat, const int stag, const double temp) {
+    sa_checkpoint c;
+    c.n_nodes = n_nodes;
+    c.capacity = ctx.capacity;
+    c.node_order = setup.node_order;
+    c.reheat = reheat;
+    c.stag_left = stag + 1;
+    c.iterations = iterations;
+    c.temp = temp;
+    c.cost = current_cost;
+    c.best_cost = best_cost;
+    std::copy(g.state(), g.state() + 4, c.rng_state);
+    c.current = vehicles;
+    rt.to_vehicles(c.current);
+    c.best = best_vehicles();
+    if (!write_checkpoint(setup.checkpoint_path, c)) {
+      std::cout << "Cannot write the checkpoint to " << setup.checkpoint_path
+                << '\n';
+    }
+    next_checkpoint = iterations + setup.checkpoint_every;
+  };
+
+  for (int r = resume ? resume->reheat : 0;
+       !stopped && (limits.anytime() || r < setup.n_reheats); r++) {
+    if (r > 0 && !resume) {
+      save_best();
+      if (shared) {
+        offer();
+        restart_if_behind();
+      }
+    }
+    int stag = resume ? resume->stag_left : stag_limit;
+    double temp = resume ? resume->temp : setup.init_temp;
+    resume = nullptr;
+    while (--stag >= 0) {
+      if (iterations >= next_check) {
+        check_limits(temp);
+        if (checkpointed && (stopped || iterations >= next_checkpoint)) {
+          checkpoint(r, stag, temp);
+        }
+        if (stopped) {
+          break;
+        }
+        if (shared) {
+          offer();
+          restart_if_behind();
+        }
+      }
+      ++iterations;
+      temp = cooling_(temp);
+      CVRP_TRACE_ON(if (trace.due(iterations)) {
+        trace.sample(iterations, temp, current_cost, best_cost);
+      })
+      double delta = 0;
+      auto accept = [&](const double d) {
+        const bool ok = accept_(d, temp, g);
+        CVRP_TRACE_ON(metropolis += !ok;)
+        return ok;
+      };
+      if (move_(ctx, rt, g, accept, delta)) {
+        CVRP_COUNT(stats, accepted);
+        current_cost += delta;
+        walk_best = std::min(walk_best, current_cost);
+        if (current_cost < best_cost) {
+          stag = stag_limit;
+          rt.commit();
+          best_in_rt = true;
+          best_cost = current_cost;
+          CVRP_COUNT(stats, improved);
+          if (shared) {
+            publish(best_cost);
+          }
+        } else if (rt.journal_size() > max_journal) {
+          save_best();
+        }
+      }
+    }
+    CVRP_TRACE_ON(counts.reheat_best.push_back(best_cost);)
+  }
+  CVRP_TRACE_ON(counts.proposed = iterations - first_iteration;
+                counts.metropolis = metropolis;)
+  CVRP_TRACE_ON(if (!setup.trace_path.empty() &&
+                    !trace.write_csv(setup.trace_path)) {
+    std::cout << "Cannot write the trace to " << setup.trace_path << '\n';
+  })
+  if (best_in_rt) {
+    rt.rollback();
+    rt.to_vehicles(vehicles);
+  } else {
+    best.to_vehicles(vehicles);
+  }
+  return {iterations, stopped};
+}
+
+#endif // ANNEAL_HPP
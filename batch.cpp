@@ -0,0 +1,159 @@
+#include "batch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+#include "alns.hpp"
+#include "greedy.hpp"
+#include "pool.hpp"
+#include "savings.hpp"
+#include "simulated_annealing.hpp"
+#include "tsplib.hpp"
+#include "utils.hpp"
+
+std::vector<batch_job> read_manifest(const std::string &path) {
+  std::ifstream in(path);
+  if (!in) {
+    throw std::runtime_error("cannot read manifest " + path);
+  }
+  std::vector<batch_job> jobs;
+  int line_no = 0;
+  auto fail = [&](const std::string &msg) {
+    throw std::runtime_error(path + ":" + std::to_string(line_no) + ": " +
+                             msg);
+  };
+  for (std::string line; std::getline(in, line);) {
+    line_no++;
+    std::istringstream iss(line);
+    batch_job job;
+    if (!(iss >> job.path) || job.path[0] == '#') {
+      continue;
+    }
+    if (!(iss >> job.n_vehicles) || job.n_vehicles < 1) {
+      fail("expected a vehicle count after the instance path");
+    }
+    iss >> job.solver;
+    if (job.solver != "nn" && job.solver != "sa" && job.solver != "hybrid" &&
+        job.solver != "cw" && job.solver != "cw-hybrid" &&
+        job.solver != "alns") {
+      fail("unknown solver " + job.solver);
+    }
+    iss >> job.seconds >> job.start;
+    // catch missing files before any job starts
+    for (const std::string *file : {&job.path, &job.start}) {
+      if (!file->empty() && !std::ifstream(*file)) {
+        fail("cannot read " + *file);
+      }
+    }
+    jobs.push_back(job);
+  }
+  return jobs;
+}
+
+namespace {
+
+struct batch_result {
+  double cost = 0;
+  bool valid = false;
+  int routes = 0;
+};
+
+batch_result solve_job(const batch_job &job) {
+  const prob p(job.path, job.n_vehicles);
+  auto finish = [](const sol &s) {
+    batch_result r;
+    r.cost = std::accumulate(
+        std::begin(s.vehicles_), std::end(s.vehicles_), 0.0,
+        [](const double sum, const veh &v) { return sum + v.cost_; });
+    r.valid = s.check_sol_val();
+    r.routes = std::count_if(
+        s.vehicles_.begin(), s.vehicles_.end(),
+        [](const veh &v) { return v.nodes_.size() > 2; });
+    return r;
+  };
+  const bool savings = job.solver == "cw" || job.solver == "cw-hybrid";
+  nn_sol nn(p);
+  std::optional<cw_sol> cw;
+  if (!job.start.empty()) {
+    const cvrplib_sol warm = read_cvrplib_sol(job.start);
+    try {
+      nn.set_routes(warm.routes);
+    } catch (const std::runtime_error &e) {
+      // the reader's errors name the file, set_routes' do not
+      throw std::runtime_error(job.start + ": " + e.what());
+    }
+  } else if (savings) {
+    cw.emplace(p);
+    cw->create_savings_sol();
+  } else {
+    nn.create_init_sol();
+  }
+  const sol &start = cw ? static_cast<const sol &>(*cw) : nn;
+  // sa_sol exits on an invalid start (customers left over, a start file
+  // breaking the capacity) and alns_sol keeps it, so it is reported as it
+  // is
+  if (job.solver == "nn" || job.solver == "cw" || !start.check_sol_val()) {
+    return finish(start);
+  }
+  sa_limits limits;
+  limits.seconds = job.seconds;
+  if (job.solver == "alns") {
+    alns_params params;
+    params.limits = limits;
+    alns_sol alns(start, params);
+    alns.run();
+    return finish(alns);
+  }
+  sa_sol sa(start, 500000, job.solver == "sa" ? 50000 : 50, 0.9899, 20, 20,
+            1);
+  sa.set_limits(limits);
+  sa.anneal();
+  return finish(sa);
+}
+
+} // namespace
+
+int run_batch(const std::vector<batch_job> &jobs, const int n_threads,
+              std::ostream &out) {
+  std::mutex out_m;
+  std::atomic<int> invalid{0};
+  out << "path,vehicles,solver,budget,cost,valid,routes,seconds" << std::endl;
+  work_pool pool(n_threads);
+  for (const auto &job : jobs) {
+    pool.submit([&job, &out, &out_m, &invalid] {
+      const auto start = std::chrono::steady_clock::now();
+      batch_result r;
+      std::string error;
+      try {
+        r = solve_job(job);
+      } catch (const std::exception &e) {
+        // a job that cannot load its files fails alone
+        error = e.what();
+      }
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      if (!r.valid) {
+        invalid++;
+      }
+      std::ostringstream row;
+      row << job.path << ',' << job.n_vehicles << ',' << job.solver << ','
+          << job.seconds << ',' << r.cost << ',' << r.valid << ','
+          << r.routes << ',' << elapsed.count() << '\n';
+      std::lock_guard<std::mutex> lock(out_m);
+      if (!error.empty()) {
+        std::cerr << "Error: " << error << '\n';
+      }
+      out << row.str() << std::flush;
+    });
+  }
+  pool.wait();
+  return invalid;
+}
@@ -0,0 +1,42 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// One line of a batch manifest:
+//   <instance path> <vehicles> [nn|sa|hybrid|cw|cw-hybrid|alns]
+//   [budget seconds] [start .sol]
+// The solver defaults to hybrid. A budget of 0 (the default) lets SA stop
+// on stagnation as usual, and ALNS after 25000 iterations. With a start
+// file (CVRPLIB .sol, such as an earlier run's routes) its routes replace
+// the solver's construction: nn and cw report them as they are, the
+// others search from them. Blank lines and lines starting with '#' are
+// skipped.
+struct batch_job {
+  std::string path;
+  int n_vehicles = 0;
+  std::string solver = "hybrid";
+  double seconds = 0;
+  std::string start;
+};
+
+// Parses a manifest. Throws std::runtime_error naming the file and line
+// on a malformed line, an unknown solver or a file that cannot be read.
+std::vector<batch_job> read_manifest(const std::string &path);
+
+// Solves every job on a work_pool of n_threads workers. Each job loads its
+// instance on the worker that runs it. A CSV row
+//   path,vehicles,solver,budget,cost,valid,routes,seconds
+// is written to out as soon as a job finishes, so rows come in completion
+// order. routes counts the non-empty routes: cw may use more than the
+// vehicles asked for while staying valid. An invalid start (the
+// construction or the start file) is not searched from and gets its own
+// row with valid 0; a job whose files fail to parse gets cost 0 and
+// valid 0, with the error on stderr. Returns the number of jobs whose
+// solution is invalid, those included.
+int run_batch(const std::vector<batch_job> &jobs, int n_threads,
+              std::ostream &out);
+
+#endif // BATCH_HPP
@@ -0,0 +1,483 @@
+// Quality-versus-time baseline over a directory of instances.
+//
+// Every X.vrp with a matching X.sol is solved by each selected solver
+// over R seeds. The reference is the "Cost" line of the .sol file and the
+// gap is 100 * (cost - ref) / ref. CVRPLIB references round every edge to
+// an integer while this solver does not, so gaps within a fraction of a
+// percent of zero are at the optimum.
+//
+// valid counts the runs that route every customer within capacity. The
+// savings construction adds vehicles when it ends with more routes than
+// the instance has, so over_fleet counts the valid runs that use more
+// routes than vehicles, and max_routes is the most any run used; such
+// runs are also noted on stderr.
+//
+// Usage: cvrp_bench <dir> [--seeds R]
+//                   [--solvers nn,sa,hybrid,cw,cw-hybrid,alns,pt]
+//                   [--stag N] [--reheats N] [--moves SPEC] [--seconds S]
+//                   [--renumber hilbert|morton] [--format csv|json]
+//                   [--check-resume]
+//
+// cw is the savings construction and cw-hybrid SA started from it, as hybrid
+// is SA started from nearest neighbour. alns is alns_sol and pt the
+// parallel tempering of pt_sol (8 replicas), both started from nearest
+// neighbour.
+//
+// --seconds gives every SA run a wall-clock budget: it keeps reheating until
+// the time is spent, whatever --reheats says. ALNS and pt runs get the
+// same budget; without one ALNS stops after 25000 iterations and pt after
+// 1000 sweeps.
+//
+// --renumber solves every instance with its customers renumbered along
+// the curve (renumber.hpp).
+//
+// --check-resume also runs, for every instance, hybrid SA for 200000
+// iterations in one go and again stopped halfway, checkpointed and
+// resumed from the file (checkpoint.hpp), and reports on stderr whether
+// both ended with the same routes. Any mismatch makes the exit status 1.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "alns.hpp"
+#include "greedy.hpp"
+#include "moves.hpp"
+#include "renumber.hpp"
+#include "savings.hpp"
+#include "simulated_annealing.hpp"
+#include "tempering.hpp"
+#include "utils.hpp"
+
+namespace {
+
+struct options {
+  std::string dir;
+  int seeds = 5;
+  std::vector<std::string> solvers = {"nn", "sa", "hybrid"};
+  int stag_limit = 500000;
+  int n_reheats = 20;
+  move_mix moves;
+  sa_limits limits;
+  curve_kind curve = curve_kind::none;
+  bool json = false;
+  bool check_resume = false;
+};
+
+struct instance {
+  std::string name;
+  std::string path;
+  int n_vehicles = 0;
+  double ref_cost = 0;
+};
+
+struct run {
+  double cost = 0;
+  bool valid = false;
+  int routes = 0;
+  double seconds = 0;
+  long long iterations = 0;
+};
+
+struct row {
+  std::string instance;
+  int n_nodes = 0;
+  int n_vehicles = 0;
+  double ref_cost = 0;
+  std::string solver;
+  int runs = 0;
+  int valid = 0;
+  int over_fleet = 0;
+  int max_routes = 0;
+  double min_gap = 0, median_gap = 0, max_gap = 0;
+  double mean_seconds = 0;
+  double iters_per_second = 0;
+};
+
+void usage() {
+  std::cout << "Usage: cvrp_bench <dir> [--seeds R] "
+               "[--solvers nn,sa,hybrid,cw,cw-hybrid,alns,pt] "
+               "[--stag N] [--reheats N] [--moves SPEC] [--seconds S] "
+               "[--renumber hilbert|morton] [--format csv|json] "
+               "[--check-resume]"
+            << '\n';
+  exit(1);
+}
+
+options parse_args(const int argc, char **argv) {
+  options opt;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    auto value = [&]() -> std::string {
+      if (i + 1 >= argc) {
+        usage();
+      }
+      return argv[++i];
+    };
+    if (arg == "--seeds") {
+      opt.seeds = std::max(1, std::stoi(value()));
+    } else if (arg == "--solvers") {
+      opt.solvers.clear();
+      std::istringstream iss(value());
+      for (std::string s; std::getline(iss, s, ',');) {
+        if (s != "nn" && s != "sa" && s != "hybrid" && s != "cw" &&
+            s != "cw-hybrid" && s != "alns" && s != "pt") {
+          std::cout << "Unknown solver: " << s << '\n';
+          usage();
+        }
+        opt.solvers.push_back(s);
+      }
+    } else if (arg == "--stag") {
+      opt.stag_limit = std::stoi(value());
+    } else if (arg == "--reheats") {
+      opt.n_reheats = std::stoi(value());
+    } else if (arg == "--moves") {
+      try {
+        opt.moves = parse_move_mix(value());
+      } catch (const std::exception &e) {
+        std::cout << e.what() << '\n';
+        usage();
+      }
+    } else if (arg == "--seconds") {
+      opt.limits.seconds = std::stod(value());
+    } else if (arg == "--renumber") {
+      try {
+        opt.curve = parse_curve_kind(value());
+      } catch (const std::exception &e) {
+        std::cout << e.what() << '\n';
+        usage();
+      }
+    } else if (arg == "--format") {
+      opt.json = value() == "json";
+    } else if (arg == "--check-resume") {
+      opt.check_resume = true;
+    } else if (opt.dir.empty() && arg[0] != '-') {
+      opt.dir = arg;
+    } else {
+      usage();
+    }
+  }
+  if (opt.dir.empty()) {
+    usage();
+  }
+  return opt;
+}
+
+// Reads the "Cost" line and counts the routes of a .sol file.
+bool read_sol(const std::string &path, double &cost, int &n_routes) {
+  std::ifstream in(path);
+  if (!in) {
+    return false;
+  }
+  bool found = false;
+  n_routes = 0;
+  for (std::string line; std::getline(in, line);) {
+    if (line.rfind("Route", 0) == 0) {
+      n_routes++;
+    } else if (line.rfind("Cost", 0) == 0) {
+      cost = std::stod(line.substr(4));
+      found = true;
+    }
+  }
+  return found;
+}
+
+std::vector<instance> find_instances(const std::string &dir) {
+  namespace fs = std::filesystem;
+  std::vector<instance> out;
+  const std::regex k_suffix("-k([0-9]+)$");
+  for (const auto &entry : fs::directory_iterator(dir)) {
+    if (entry.path().extension() != ".vrp") {
+      continue;
+    }
+    instance inst;
+    inst.name = entry.path().stem().string();
+    inst.path = entry.path().string();
+    fs::path sol_path = entry.path();
+    sol_path.replace_extension(".sol");
+    int n_routes = 0;
+    if (!read_sol(sol_path.string(), inst.ref_cost, n_routes)) {
+      std::cerr << "skipping " << inst.name << ": no reference cost\n";
+      continue;
+    }
+    // vehicle count from the "-kN" suffix, else from the reference
+    std::smatch m;
+    inst.n_vehicles =
+        std::regex_search(inst.name, m, k_suffix) ? std::stoi(m[1]) : n_routes;
+    out.push_back(inst);
+  }
+  std::sort(out.begin(), out.end(),
+            [](const instance &a, const instance &b) { return a.name < b.name; });
+  return out;
+}
+
+// Total cost recomputed from the routes, so drift in the incremental costs
+// cannot flatter the result.
+double route_cost(const sol &s) {
+  double cost = 0;
+  for (veh v : s.vehicles_) {
+    v.calc_cost(s.dist_mtx_);
+    cost += v.cost_;
+  }
+  return cost;
+}
+
+// Routes that visit a customer.
+int used_routes(const sol &s) {
+  return std::count_if(s.vehicles_.begin(), s.vehicles_.end(),
+                       [](const veh &v) { return v.nodes_.size() > 2; });
+}
+
+run solve_once(const prob &p, const std::string &solver, const uint64_t seed,
+               const options &opt) {
+  run r;
+  const auto start = std::chrono::steady_clock::now();
+  if (solver == "nn") {
+    nn_sol nn(p);
+    nn.create_init_sol();
+    r.cost = route_cost(nn);
+    r.valid = nn.check_sol_val();
+    r.routes = used_routes(nn);
+  } else if (solver == "sa") {
+    sa_sol sa(p, opt.stag_limit, 50000, 0.9899, opt.n_reheats, 20, seed);
+    sa.set_moves(opt.moves);
+    sa.set_limits(opt.limits);
+    sa.anneal();
+    r.cost = route_cost(sa);
+    r.valid = sa.check_sol_val();
+    r.routes = used_routes(sa);
+    r.iterations = sa.iterations();
+  } else if (solver == "cw") {
+    cw_sol cw(p);
+    cw.create_savings_sol();
+    r.cost = route_cost(cw);
+    r.valid = cw.check_sol_val();
+    r.routes = used_routes(cw);
+  } else if (solver == "cw-hybrid") {
+    cw_sol cw(p);
+    cw.create_savings_sol();
+    sa_sol sa(cw, opt.stag_limit, 50, 0.9899, opt.n_reheats, 20, seed);
+    sa.set_moves(opt.moves);
+    sa.set_limits(opt.limits);
+    sa.anneal();
+    r.cost = route_cost(sa);
+    r.valid = sa.check_sol_val();
+    r.routes = used_routes(sa);
+    r.iterations = sa.iterations();
+  } else if (solver == "alns") {
+    nn_sol nn(p);
+    nn.create_init_sol();
+    alns_params params;
+    params.seed = seed;
+    params.limits = opt.limits;
+    alns_sol alns(nn, params);
+    alns.run();
+    r.cost = route_cost(alns);
+    r.valid = alns.check_sol_val();
+    r.routes = used_routes(alns);
+    r.iterations = alns.iterations();
+  } else if (solver == "pt") {
+    nn_sol nn(p);
+    nn.create_init_sol();
+    pt_sol pt(nn, 8, 0.5, 50, 1000, 10000, 20, seed);
+    pt.set_moves(opt.moves);
+    pt.set_limits(opt.limits);
+    pt.temper();
+    r.cost = route_cost(pt);
+    r.valid = pt.check_sol_val();
+    r.routes = used_routes(pt);
+    r.iterations = pt.iterations();
+  } else {
+    nn_sol nn(p);
+    nn.create_init_sol();
+    sa_sol sa(nn, opt.stag_limit, 50, 0.9899, opt.n_reheats, 20, seed);
+    sa.set_moves(opt.moves);
+    sa.set_limits(opt.limits);
+    sa.anneal();
+    r.cost = route_cost(sa);
+    r.valid = sa.check_sol_val();
+    r.routes = used_routes(sa);
+    r.iterations = sa.iterations();
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  r.seconds = elapsed.count();
+  return r;
+}
+
+// Whether hybrid SA stopped halfway through an iteration budget,
+// checkpointed and resumed ends with the routes of the run made in one go.
+bool resume_matches(const prob &p, const options &opt) {
+  nn_sol nn(p);
+  nn.create_init_sol();
+  if (!nn.check_sol_val()) {
+    std::cerr << "resume check: no valid start\n";
+    return false;
+  }
+  const long long budget = 200000;
+  sa_limits whole, half;
+  whole.iterations = budget;
+  half.iterations = budget / 2;
+  const std::string path =
+      (std::filesystem::temp_directory_path() / "cvrp_bench_resume.ckpt")
+          .string();
+
+  sa_sol straight(nn, opt.stag_limit, 50, 0.9899, opt.n_reheats, 20, 1);
+  straight.set_moves(opt.moves);
+  straight.set_limits(whole);
+  straight.anneal();
+
+  sa_sol first(nn, opt.stag_limit, 50, 0.9899, opt.n_reheats, 20, 1);
+  first.set_moves(opt.moves);
+  first.set_limits(half);
+  first.checkpoint_to(path, budget);
+  first.anneal();
+
+  sa_sol second(nn, opt.stag_limit, 50, 0.9899, opt.n_reheats, 20, 1);
+  second.set_moves(opt.moves);
+  second.set_limits(whole);
+  try {
+    second.resume_from(path);
+  } catch (const std::exception &e) {
+    std::cerr << "resume check: " << e.what() << '\n';
+    std::remove(path.c_str());
+    return false;
+  }
+  second.anneal();
+  std::remove(path.c_str());
+  return second.get_routes() == straight.get_routes() &&
+         second.iterations() == straight.iterations();
+}
+
+row summarize(const instance &inst, const int n_nodes,
+              const std::string &solver, const std::vector<run> &runs) {
+  row out;
+  out.instance = inst.name;
+  out.n_nodes = n_nodes;
+  out.n_vehicles = inst.n_vehicles;
+  out.ref_cost = inst.ref_cost;
+  out.solver = solver;
+  out.runs = runs.size();
+  std::vector<double> gaps;
+  double seconds = 0;
+  long long iterations = 0;
+  for (const auto &r : runs) {
+    seconds += r.seconds;
+    iterations += r.iterations;
+    if (r.valid) {
+      gaps.push_back(100 * (r.cost - inst.ref_cost) / inst.ref_cost);
+      out.over_fleet += r.routes > inst.n_vehicles;
+    }
+    out.max_routes = std::max(out.max_routes, r.routes);
+  }
+  out.valid = gaps.size();
+  if (!gaps.empty()) {
+    std::sort(gaps.begin(), gaps.end());
+    const size_t m = gaps.size();
+    out.min_gap = gaps.front();
+    out.max_gap = gaps.back();
+    out.median_gap =
+        m % 2 ? gaps[m / 2] : (gaps[m / 2 - 1] + gaps[m / 2]) / 2;
+  }
+  out.mean_seconds = seconds / runs.size();
+  out.iters_per_second = seconds > 0 ? iterations / seconds : 0;
+  return out;
+}
+
+void print_csv(const std::vector<row> &rows) {
+  std::cout << "instance,nodes,vehicles,ref_cost,solver,runs,valid,min_gap,"
+               "median_gap,max_gap,mean_seconds,iters_per_second,"
+               "max_routes,over_fleet\n";
+  for (const auto &r : rows) {
+    std::cout << r.instance << ',' << r.n_nodes << ',' << r.n_vehicles << ','
+              << r.ref_cost << ',' << r.solver << ',' << r.runs << ','
+              << r.valid << ',' << r.min_gap << ',' << r.median_gap << ','
+              << r.max_gap << ',' << r.mean_seconds << ','
+              << r.iters_per_second << ',' << r.max_routes << ','
+              << r.over_fleet << '\n';
+  }
+}
+
+void print_json(const std::vector<row> &rows) {
+  std::cout << "[\n";
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const row &r = rows[i];
+    std::cout << "  {\"instance\": \"" << r.instance
+              << "\", \"nodes\": " << r.n_nodes
+              << ", \"vehicles\": " << r.n_vehicles
+              << ", \"ref_cost\": " << r.ref_cost << ", \"solver\": \""
+              << r.solver << "\", \"runs\": " << r.runs
+              << ", \"valid\": " << r.valid << ", \"min_gap\": " << r.min_gap
+              << ", \"median_gap\": " << r.median_gap
+              << ", \"max_gap\": " << r.max_gap
+              << ", \"mean_seconds\": " << r.mean_seconds
+              << ", \"iters_per_second\": " << r.iters_per_second
+              << ", \"max_routes\": " << r.max_routes
+              << ", \"over_fleet\": " << r.over_fleet << "}"
+              << (i + 1 < rows.size() ? "," : "") << '\n';
+  }
+  std::cout << "]\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const options opt = parse_args(argc, argv);
+  const std::vector<instance> instances = find_instances(opt.dir);
+  if (instances.empty()) {
+    std::cout << "No instances with a reference .sol in " << opt.dir << '\n';
+    return 1;
+  }
+
+  std::vector<row> rows;
+  int resume_mismatches = 0;
+  for (const auto &inst : instances) {
+    prob p('#');
+    try {
+      p = prob(inst.path, inst.n_vehicles);
+    } catch (const std::exception &e) {
+      std::cerr << "skipping " << inst.name << ": " << e.what() << '\n';
+      continue;
+    }
+    renumber(p, opt.curve);
+    if (opt.check_resume) {
+      const bool same = resume_matches(p, opt);
+      resume_mismatches += !same;
+      std::cerr << inst.name << " resume check: "
+                << (same ? "same routes" : "MISMATCH") << '\n';
+    }
+    for (const auto &solver : opt.solvers) {
+      std::vector<run> runs;
+      // nn and cw are deterministic, one run is enough
+      const int n_seeds = solver == "nn" || solver == "cw" ? 1 : opt.seeds;
+      for (int s = 1; s <= n_seeds; ++s) {
+        runs.push_back(solve_once(p, solver, s, opt));
+      }
+      rows.push_back(summarize(inst, p.nodes_.size(), solver, runs));
+      if (rows.back().over_fleet > 0) {
+        std::cerr << inst.name << ' ' << solver << ": "
+                  << rows.back().over_fleet << " valid runs use more than "
+                  << inst.n_vehicles << " routes (up to "
+                  << rows.back().max_routes << ")\n";
+      }
+      std::cerr << inst.name << ' ' << solver << " done\n";
+    }
+  }
+
+  std::cout << std::setprecision(6);
+  if (opt.json) {
+    print_json(rows);
+  } else {
+    print_csv(rows);
+  }
+  return resume_mismatches > 0;
+}
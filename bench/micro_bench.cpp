@@ -0,0 +1,334 @@
+// Microbenchmarks of the solver hot paths on generated instances.
+//
+// For every size and distribution (uniform, cluster) it times
+//   dist_build    - dist_mtx construction, per matrix entry (not for the
+//                   implicit backend, which has no matrix)
+//   find_closest  - one nearest-feasible scan from a random node
+//   calc_cost     - veh::calc_cost, per route edge
+//   check_sol_val - one validity check of a complete solution
+//   sa_delta      - one SA relocate proposal, evaluated and rejected
+//   sa_apply      - one SA relocate proposal, evaluated and applied
+//   sa_loop       - one iteration of the relocate-only annealer, with
+//                   distances through the run-time switch of dist_mtx
+//   sa_loop_view  - the same through a dist_view of the backend, as sa_sol
+//                   runs it
+//   sa_loop_hilbert, sa_loop_morton
+//                 - sa_loop_view with the customers renumbered along the
+//                   curve (renumber.hpp)
+// and prints ns per operation, the bytes an operation reads or writes
+// (logical, cache effects aside) and the hardware cache misses per
+// operation. The misses are read through perf_event_open and shown as n/a
+// where the kernel offers no such counter (most VMs, or
+// perf_event_paranoid above 2).
+//
+// Usage: micro_bench [--max-n N] [--min-time SECONDS]
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "anneal.hpp"
+#include "greedy.hpp"
+#include "moves.hpp"
+#include "neighbors.hpp"
+#include "renumber.hpp"
+#include "rng.hpp"
+#include "routes.hpp"
+#include "utils.hpp"
+
+namespace {
+
+double min_time = 0.2;
+
+// Keeps a result alive so the timed work is not optimized away.
+volatile double sink = 0;
+
+// Hardware cache misses (last level, as the kernel defines
+// PERF_COUNT_HW_CACHE_MISSES) of this thread between start() and stop().
+class miss_counter {
+public:
+  miss_counter() {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+
+  ~miss_counter() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  miss_counter(const miss_counter &) = delete;
+
+  miss_counter &operator=(const miss_counter &) = delete;
+
+  bool available() const { return fd_ >= 0; }
+
+  void start() {
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  // Misses since start(), or -1 without a counter.
+  double stop() {
+    uint64_t count = 0;
+    if (fd_ < 0) {
+      return -1;
+    }
+    ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+      return -1;
+    }
+    return count;
+  }
+
+private:
+  int fd_ = -1;
+};
+
+miss_counter *misses = nullptr;
+
+// Cache misses per operation of the last time_ns, -1 when not counted.
+double last_misses = -1;
+
+// Calls f(batch) with growing batches until min_time has passed and
+// returns the time per operation in ns, f doing ops_per_call operations
+// per iteration of its batch. The misses of the last batch go to
+// last_misses.
+template <typename F> double time_ns(F f, const double ops_per_call = 1) {
+  long long batch = 1;
+  while (true) {
+    misses->start();
+    const auto start = std::chrono::steady_clock::now();
+    f(batch);
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    const double missed = misses->stop();
+    if (elapsed.count() >= min_time) {
+      last_misses = missed < 0 ? -1 : missed / (batch * ops_per_call);
+      return elapsed.count() * 1e9 / (batch * ops_per_call);
+    }
+    batch *= elapsed.count() > min_time / 100 ? 2 : 10;
+  }
+}
+
+void report(const char *kernel, const std::string &dist, const int n,
+            const dist_kind kind, const double ns, const double bytes) {
+  char missed[32] = "n/a";
+  if (last_misses >= 0) {
+    std::snprintf(missed, sizeof(missed), "%.3f", last_misses);
+  }
+  std::printf("%-16s %-8s %7d %-9s %12.2f %12.0f %8.2f %10s\n", kernel,
+              dist.c_str(), n, to_string(kind).c_str(), ns, bytes,
+              bytes / ns, missed);
+}
+
+// ns per iteration of the relocate-only annealer from start, in batches of
+// 1000 iterations, with distances through d.
+template <typename D>
+double loop_ns(const sol &start, const nbr_list &nbrs, const D &d, rng &g) {
+  const basic_move_ctx<D> ctx{start.nodes_, d, nbrs, start.capacity_};
+  const annealer<single_move<mv_relocate>, metropolis, geometric_cooling, D>
+      sa({}, {}, {0.9999});
+  anneal_setup setup;
+  setup.init_temp = 50;
+  return time_ns(
+      [&](const long long batch) {
+        std::vector<veh> vehicles = start.vehicles_;
+        setup.limits.iterations = batch * 1000;
+        sink = sink + sa.run(setup, ctx, vehicles, g).iterations;
+      },
+      1000);
+}
+
+// loop_ns through the dist_view of the backend, as sa_sol runs it.
+double view_loop_ns(const sol &start, const nbr_list &nbrs, rng &g) {
+  const dist_mtx &d = start.dist_mtx_;
+  switch (d.kind()) {
+  case dist_kind::flat:
+    return loop_ns(start, nbrs, dist_view<dist_kind::flat>(d), g);
+  case dist_kind::compact:
+    return loop_ns(start, nbrs, dist_view<dist_kind::compact>(d), g);
+  default:
+    return loop_ns(start, nbrs, dist_view<dist_kind::implicit>(d), g);
+  }
+}
+
+// Largest backend that keeps the matrix under 512 MB.
+dist_kind backend_for(const int n) {
+  const double n2 = static_cast<double>(n) * n;
+  if (n2 * sizeof(double) <= 512e6) {
+    return dist_kind::flat;
+  }
+  if (n2 / 2 * sizeof(float) <= 512e6) {
+    return dist_kind::compact;
+  }
+  return dist_kind::implicit;
+}
+
+void bench_size(const int n, const std::string &dist) {
+  const dist_kind kind = backend_for(n);
+  // ~40 customers per vehicle at the default demands, with slack
+  const int nov = n / 30 + 2;
+  const prob p(n - 1, 40, nov, 800, 1000, dist, 5, 10, kind, 7);
+  const size_t nodes = p.nodes_.size();
+  rng g(7);
+
+  if (kind != dist_kind::implicit) {
+    std::vector<double> xs, ys;
+    for (const auto &node : p.nodes_) {
+      xs.push_back(node.x_);
+      ys.push_back(node.y_);
+    }
+    const dist_mtx built(xs, ys, kind);
+    const double entries = static_cast<double>(nodes) * nodes;
+    const double ns = time_ns(
+        [&](const long long batch) {
+          for (long long b = 0; b < batch; ++b) {
+            const dist_mtx d(xs, ys, kind);
+            sink = sink + d(0, nodes - 1);
+          }
+        },
+        entries);
+    report("dist_build", dist, n, kind, ns, built.bytes() / entries);
+  }
+
+  // half of the customers routed, as midway through construction
+  nn_sol half(p);
+  for (size_t i = 1; i < nodes; i += 2) {
+    half.mark_routed(i);
+  }
+  {
+    veh v(0, 800, 800);
+    v.nodes_.push_back(0);
+    const double row_bytes = kind == dist_kind::flat      ? sizeof(double)
+                             : kind == dist_kind::compact ? sizeof(float)
+                                                          : 2 * sizeof(double);
+    const double ns = time_ns([&](const long long batch) {
+      for (long long b = 0; b < batch; ++b) {
+        v.nodes_[0] = g.below(nodes);
+        sink = sink + std::get<1>(half.find_closest(v)).id_;
+      }
+    });
+    report("find_closest", dist, n, kind, ns,
+           nodes * (row_bytes + sizeof(int)));
+  }
+
+  nn_sol full(p);
+  full.create_init_sol();
+  {
+    // one route through every node in random order
+    veh v(0, 800, 800);
+    v.nodes_.resize(nodes);
+    for (size_t i = 0; i < nodes; ++i) {
+      v.nodes_[i] = i;
+    }
+    for (size_t i = nodes - 1; i > 1; --i) {
+      std::swap(v.nodes_[i], v.nodes_[1 + g.below(i)]);
+    }
+    v.nodes_.push_back(0);
+    const double ns = time_ns(
+        [&](const long long batch) {
+          for (long long b = 0; b < batch; ++b) {
+            v.calc_cost(full.dist_mtx_);
+            sink = sink + v.cost_;
+          }
+        },
+        nodes);
+    report("calc_cost", dist, n, kind, ns, sizeof(int) + sizeof(double));
+  }
+  {
+    const double ns = time_ns([&](const long long batch) {
+      for (long long b = 0; b < batch; ++b) {
+        sink = sink + full.check_sol_val();
+      }
+    });
+    report("check_sol_val", dist, n, kind, ns,
+           nodes * (sizeof(int) + sizeof(nd)));
+  }
+
+  const nbr_list nbrs(full.nodes_, full.dist_mtx_, 20);
+  // the ints and six distances a relocation reads
+  const double move_bytes = 12 * sizeof(int) + 6 * sizeof(double);
+  {
+    const move_ctx ctx{full.nodes_, full.dist_mtx_, nbrs, full.capacity_};
+    routes rt(full.vehicles_, full.nodes_);
+    double delta = 0;
+    const double reject_ns = time_ns([&](const long long batch) {
+      for (long long b = 0; b < batch; ++b) {
+        relocate_move(
+            ctx, rt, g, [](const double) { return false; }, delta);
+      }
+    });
+    report("sa_delta", dist, n, kind, reject_ns, move_bytes);
+    long long applied = 0;
+    const double apply_ns = time_ns([&](const long long batch) {
+      for (long long b = 0; b < batch; ++b) {
+        applied += relocate_move(
+            ctx, rt, g, [](const double) { return true; }, delta);
+        if (rt.journal_size() > 4096) {
+          rt.rollback();
+        }
+      }
+    });
+    sink = sink + applied;
+    report("sa_apply", dist, n, kind, apply_ns, move_bytes);
+  }
+
+  // from the nearest-neighbour solution
+  report("sa_loop", dist, n, kind, loop_ns(full, nbrs, full.dist_mtx_, g),
+         move_bytes);
+  report("sa_loop_view", dist, n, kind, view_loop_ns(full, nbrs, g),
+         move_bytes);
+
+  for (const curve_kind curve : {curve_kind::hilbert, curve_kind::morton}) {
+    prob q = p;
+    renumber(q, curve);
+    nn_sol start(q);
+    start.create_init_sol();
+    const nbr_list q_nbrs(start.nodes_, start.dist_mtx_, 20);
+    const double ns = view_loop_ns(start, q_nbrs, g);
+    report(("sa_loop_" + to_string(curve)).c_str(), dist, n, kind, ns,
+           move_bytes);
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int max_n = 100000;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string arg = argv[i];
+    if (arg == "--max-n") {
+      max_n = std::stoi(argv[i + 1]);
+    } else if (arg == "--min-time") {
+      min_time = std::stod(argv[i + 1]);
+    }
+  }
+  miss_counter counter;
+  misses = &counter;
+  std::printf("%-16s %-8s %7s %-9s %12s %12s %8s %10s\n", "kernel", "dist",
+              "n", "backend", "ns/op", "bytes/op", "GB/s", "misses/op");
+  for (int n = 100; n <= max_n; n *= 10) {
+    for (const std::string dist : {"uniform", "cluster"}) {
+      bench_size(n, dist);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,389 @@
+// Scaling benchmark over generated instances.
+//
+// Sweeps the instance size n (customers + depot) for the uniform and the
+// cluster distribution of prob's generator, instance and solver seeded
+// with 1..R, and records for every run
+//   generate_seconds  - prob construction, distance matrix included
+//   construct_seconds - the start solution (nearest neighbour or savings)
+//   setup_seconds     - building the search on it (candidate lists)
+//   solve_seconds     - the search itself
+//   iters_per_second  - search iterations over solve_seconds
+//   peak_rss_kb       - peak resident memory of the run
+//   cost, valid       - cost recomputed from the routes, and validity
+//   routes, fleet     - non-empty routes and the instance's vehicles; dc
+//                       may need more routes than the fleet has
+// as a CSV or JSON row. Every run is forked into a child process, so the
+// peak RSS is that run's alone and a run killed by the OOM killer or a
+// crash is reported with status "failed" rather than ending the sweep.
+// The distance backend is the largest that keeps the matrix under 512 MB,
+// as in micro_bench.
+//
+// Usage: scale_bench [--sizes 100,1000,10000,100000] [--seeds R]
+//                    [--solvers nn,cw,hybrid,cw-hybrid,alns,dc] [--seconds S]
+//                    [--curves none,hilbert,morton] [--format csv|json]
+//
+// dc is the cluster-first solve of decompose.hpp (dc_sol, sweep regions
+// of 1000 customers); its construction is part of solve_seconds, and its
+// regions share the budget in waves of as many as there are threads.
+// --seconds is the budget of every search, 5 by default. Every run is
+// repeated for each of --curves, the customers renumbered along it
+// (renumber.hpp, included in generate_seconds); none only by default.
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "alns.hpp"
+#include "decompose.hpp"
+#include "greedy.hpp"
+#include "renumber.hpp"
+#include "savings.hpp"
+#include "simulated_annealing.hpp"
+#include "utils.hpp"
+
+namespace {
+
+struct options {
+  std::vector<int> sizes = {100, 1000, 10000, 100000};
+  int seeds = 1;
+  std::vector<std::string> solvers = {"nn", "cw", "hybrid", "cw-hybrid",
+                                      "alns"};
+  double seconds = 5;
+  std::vector<curve_kind> curves = {curve_kind::none};
+  bool json = false;
+};
+
+// What a child reports back through its pipe.
+struct measure {
+  double generate_seconds = 0;
+  double construct_seconds = 0;
+  double setup_seconds = 0;
+  double solve_seconds = 0;
+  long long iterations = 0;
+  double cost = 0;
+  bool valid = false;
+  int routes = 0;
+  int fleet = 0;
+};
+
+struct row {
+  int n = 0;
+  std::string dist;
+  std::string backend;
+  std::string curve;
+  std::string solver;
+  int seed = 0;
+  bool ok = false;
+  measure m;
+  long peak_rss_kb = 0;
+};
+
+void usage() {
+  std::cout << "Usage: scale_bench [--sizes 100,1000,10000,100000] "
+               "[--seeds R] [--solvers nn,cw,hybrid,cw-hybrid,alns,dc] "
+               "[--seconds S] [--curves none,hilbert,morton] "
+               "[--format csv|json]"
+            << '\n';
+  exit(1);
+}
+
+options parse_args(const int argc, char **argv) {
+  options opt;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    auto value = [&]() -> std::string {
+      if (i + 1 >= argc) {
+        usage();
+      }
+      return argv[++i];
+    };
+    if (arg == "--sizes") {
+      opt.sizes.clear();
+      std::istringstream iss(value());
+      for (std::string s; std::getline(iss, s, ',');) {
+        const int n = std::stoi(s);
+        if (n < 2) {
+          std::cout << "Size too small: " << s << '\n';
+          usage();
+        }
+        opt.sizes.push_back(n);
+      }
+    } else if (arg == "--seeds") {
+      opt.seeds = std::max(1, std::stoi(value()));
+    } else if (arg == "--solvers") {
+      opt.solvers.clear();
+      std::istringstream iss(value());
+      for (std::string s; std::getline(iss, s, ',');) {
+        if (s != "nn" && s != "cw" && s != "hybrid" && s != "cw-hybrid" &&
+            s != "alns" && s != "dc") {
+          std::cout << "Unknown solver: " << s << '\n';
+          usage();
+        }
+        opt.solvers.push_back(s);
+      }
+    } else if (arg == "--seconds") {
+      opt.seconds = std::stod(value());
+    } else if (arg == "--curves") {
+      opt.curves.clear();
+      std::istringstream iss(value());
+      for (std::string s; std::getline(iss, s, ',');) {
+        try {
+          opt.curves.push_back(parse_curve_kind(s));
+        } catch (const std::exception &e) {
+          std::cout << e.what() << '\n';
+          usage();
+        }
+      }
+    } else if (arg == "--format") {
+      opt.json = value() == "json";
+    } else {
+      usage();
+    }
+  }
+  return opt;
+}
+
+// Largest backend that keeps the matrix under 512 MB.
+dist_kind backend_for(const int n) {
+  const double n2 = static_cast<double>(n) * n;
+  if (n2 * sizeof(double) <= 512e6) {
+    return dist_kind::flat;
+  }
+  if (n2 / 2 * sizeof(float) <= 512e6) {
+    return dist_kind::compact;
+  }
+  return dist_kind::implicit;
+}
+
+double seconds_since(const std::chrono::steady_clock::time_point start) {
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+// Total cost recomputed from the routes, as in cvrp_bench.
+double route_cost(const sol &s) {
+  double cost = 0;
+  for (veh v : s.vehicles_) {
+    v.calc_cost(s.dist_mtx_);
+    cost += v.cost_;
+  }
+  return cost;
+}
+
+// Routes that visit a customer.
+int used_routes(const sol &s) {
+  return std::count_if(s.vehicles_.begin(), s.vehicles_.end(),
+                       [](const veh &v) { return v.nodes_.size() > 2; });
+}
+
+// One run, in the child process.
+measure run_once(const int n, const std::string &dist,
+                 const curve_kind curve, const std::string &solver,
+                 const int seed, const options &opt) {
+  measure m;
+  auto start = std::chrono::steady_clock::now();
+  // ~40 customers per vehicle at the default demands, with slack
+  prob p(n - 1, 40, n / 30 + 2, 800, 1000, dist, 5, 10, backend_for(n), seed);
+  renumber(p, curve);
+  m.generate_seconds = seconds_since(start);
+  m.fleet = p.vehicles_.size();
+
+  if (solver == "dc") {
+    dc_params params;
+    params.sub.seed = seed;
+    params.repair.seed = seed;
+    const int n_regions =
+        std::max(1, (n - 1 + params.region_size / 2) / params.region_size);
+    const int threads = std::max(1, params.n_threads);
+    params.sub.limits.seconds =
+        opt.seconds / ((n_regions + threads - 1) / threads);
+    start = std::chrono::steady_clock::now();
+    dc_sol dc(p, params);
+    dc.run();
+    m.solve_seconds = seconds_since(start);
+    m.iterations = dc.iterations();
+    m.cost = route_cost(dc);
+    m.valid = dc.check_sol_val();
+    m.routes = used_routes(dc);
+    return m;
+  }
+
+  start = std::chrono::steady_clock::now();
+  nn_sol nn(p);
+  cw_sol cw(p);
+  const bool savings = solver == "cw" || solver == "cw-hybrid";
+  if (savings) {
+    cw.create_savings_sol();
+  } else {
+    nn.create_init_sol();
+  }
+  const sol &init = savings ? static_cast<const sol &>(cw) : nn;
+  m.construct_seconds = seconds_since(start);
+  if (solver == "nn" || solver == "cw") {
+    m.cost = route_cost(init);
+    m.valid = init.check_sol_val();
+    m.routes = used_routes(init);
+    return m;
+  }
+
+  start = std::chrono::steady_clock::now();
+  sa_limits limits;
+  limits.seconds = opt.seconds;
+  if (solver == "alns") {
+    alns_params params;
+    params.seed = seed;
+    params.limits = limits;
+    alns_sol alns(init, params);
+    m.setup_seconds = seconds_since(start);
+    start = std::chrono::steady_clock::now();
+    alns.run();
+    m.solve_seconds = seconds_since(start);
+    m.iterations = alns.iterations();
+    m.cost = route_cost(alns);
+    m.valid = alns.check_sol_val();
+    m.routes = used_routes(alns);
+  } else {
+    sa_sol sa(init, 500000, 50, 0.9899, 20, 20, seed);
+    sa.set_limits(limits);
+    m.setup_seconds = seconds_since(start);
+    start = std::chrono::steady_clock::now();
+    sa.anneal();
+    m.solve_seconds = seconds_since(start);
+    m.iterations = sa.iterations();
+    m.cost = route_cost(sa);
+    m.valid = sa.check_sol_val();
+    m.routes = used_routes(sa);
+  }
+  return m;
+}
+
+// Runs run_once in a child and collects its measure and peak RSS.
+row run_forked(const int n, const std::string &dist, const curve_kind curve,
+               const std::string &solver, const int seed,
+               const options &opt) {
+  row r;
+  r.n = n;
+  r.dist = dist;
+  r.backend = to_string(backend_for(n));
+  r.curve = to_string(curve);
+  r.solver = solver;
+  r.seed = seed;
+  int fds[2];
+  if (pipe(fds) != 0) {
+    std::cout << "Error: cannot create a pipe" << '\n';
+    exit(1);
+  }
+  std::cout.flush();
+  const pid_t pid = fork();
+  if (pid < 0) {
+    std::cout << "Error: cannot fork" << '\n';
+    exit(1);
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    const measure m = run_once(n, dist, curve, solver, seed, opt);
+    const bool sent = write(fds[1], &m, sizeof(m)) == sizeof(m);
+    _exit(sent ? 0 : 1);
+  }
+  close(fds[1]);
+  const bool got = read(fds[0], &r.m, sizeof(r.m)) == sizeof(r.m);
+  close(fds[0]);
+  int status = 0;
+  rusage usage{};
+  wait4(pid, &status, 0, &usage);
+  r.ok = got && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  r.peak_rss_kb = usage.ru_maxrss; // KB on Linux
+  return r;
+}
+
+double iters_per_second(const row &r) {
+  return r.m.solve_seconds > 0 ? r.m.iterations / r.m.solve_seconds : 0;
+}
+
+void print_csv_header() {
+  std::cout << "n,dist,backend,curve,solver,seed,status,generate_seconds,"
+               "construct_seconds,setup_seconds,solve_seconds,iterations,"
+               "iters_per_second,peak_rss_kb,cost,valid,routes,fleet"
+            << std::endl;
+}
+
+void print_csv(const row &r) {
+  std::cout << r.n << ',' << r.dist << ',' << r.backend << ',' << r.curve
+            << ',' << r.solver << ',' << r.seed << ','
+            << (r.ok ? "ok" : "failed") << ',' << r.m.generate_seconds << ','
+            << r.m.construct_seconds << ',' << r.m.setup_seconds << ','
+            << r.m.solve_seconds << ',' << r.m.iterations << ','
+            << iters_per_second(r) << ',' << r.peak_rss_kb << ',' << r.m.cost
+            << ',' << r.m.valid << ',' << r.m.routes << ',' << r.m.fleet
+            << std::endl;
+}
+
+void print_json(const std::vector<row> &rows) {
+  std::cout << "[\n";
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const row &r = rows[i];
+    std::cout << "  {\"n\": " << r.n << ", \"dist\": \"" << r.dist
+              << "\", \"backend\": \"" << r.backend << "\", \"curve\": \""
+              << r.curve << "\", \"solver\": \"" << r.solver
+              << "\", \"seed\": " << r.seed
+              << ", \"status\": \"" << (r.ok ? "ok" : "failed")
+              << "\", \"generate_seconds\": " << r.m.generate_seconds
+              << ", \"construct_seconds\": " << r.m.construct_seconds
+              << ", \"setup_seconds\": " << r.m.setup_seconds
+              << ", \"solve_seconds\": " << r.m.solve_seconds
+              << ", \"iterations\": " << r.m.iterations
+              << ", \"iters_per_second\": " << iters_per_second(r)
+              << ", \"peak_rss_kb\": " << r.peak_rss_kb
+              << ", \"cost\": " << r.m.cost << ", \"valid\": " << r.m.valid
+              << ", \"routes\": " << r.m.routes << ", \"fleet\": " << r.m.fleet
+              << "}" << (i + 1 < rows.size() ? "," : "") << '\n';
+  }
+  std::cout << "]\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const options opt = parse_args(argc, argv);
+  std::cout << std::setprecision(6);
+  // CSV rows are printed as runs finish, so a long sweep can be watched
+  // (and plotted) while it goes
+  if (!opt.json) {
+    print_csv_header();
+  }
+  std::vector<row> rows;
+  for (const int n : opt.sizes) {
+    for (const std::string dist : {"uniform", "cluster"}) {
+      for (const curve_kind curve : opt.curves) {
+        for (const auto &solver : opt.solvers) {
+          for (int s = 1; s <= opt.seeds; ++s) {
+            rows.push_back(run_forked(n, dist, curve, solver, s, opt));
+            if (!opt.json) {
+              print_csv(rows.back());
+            }
+            std::cerr << n << ' ' << dist << ' ' << to_string(curve) << ' '
+                      << solver << ' ' << s << " done\n";
+          }
+        }
+      }
+    }
+  }
+  if (opt.json) {
+    print_json(rows);
+  }
+  int failed = 0;
+  for (const auto &r : rows) {
+    failed += !r.ok || !r.m.valid;
+  }
+  return failed > 0;
+}
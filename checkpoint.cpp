@@ -0,0 +1,170 @@
+#include "checkpoint.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "mapped_file.hpp"
+
+namespace {
+
+const char magic[8] = {'C', 'V', 'R', 'P', 'C', 'K', 'P', 'T'};
+
+template <typename T> void put(std::string &buf, const T value) {
+  buf.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void put_routes(std::string &buf, const std::vector<veh> &vehicles) {
+  for (const auto &v : vehicles) {
+    put<int32_t>(buf, v.load_);
+    put<int32_t>(buf, v.nodes_.size() - 2);
+    put<double>(buf, v.cost_);
+  }
+  for (const auto &v : vehicles) {
+    for (size_t i = 1; i + 1 < v.nodes_.size(); ++i) {
+      put<int32_t>(buf, v.nodes_[i]);
+    }
+  }
+}
+
+// Bounds-checked reads from the mapping; fields may be unaligned.
+class reader {
+public:
+  reader(const mapped_file &file, const std::string &path)
+      : p_(file.begin()), end_(file.end()), path_(path) {}
+
+  template <typename T> T get() {
+    if (static_cast<size_t>(end_ - p_) < sizeof(T)) {
+      fail("file cut short");
+    }
+    T value;
+    std::memcpy(&value, p_, sizeof(T));
+    p_ += sizeof(T);
+    return value;
+  }
+
+  std::vector<veh> routes(const int n_routes, const int n_nodes,
+                          const int capacity) {
+    std::vector<veh> vehicles;
+    std::vector<int> sizes;
+    for (int r = 0; r < n_routes; ++r) {
+      vehicles.emplace_back(r, get<int32_t>(), capacity);
+      sizes.push_back(get<int32_t>());
+      vehicles.back().cost_ = get<double>();
+      if (sizes.back() < 0) {
+        fail("negative route size");
+      }
+    }
+    for (int r = 0; r < n_routes; ++r) {
+      auto &nodes = vehicles[r].nodes_;
+      nodes.assign(1, 0);
+      for (int k = 0; k < sizes[r]; ++k) {
+        const int id = get<int32_t>();
+        if (id < 1 || id >= n_nodes) {
+          fail("customer id " + std::to_string(id) + " out of range");
+        }
+        nodes.push_back(id);
+      }
+      nodes.push_back(0);
+    }
+    return vehicles;
+  }
+
+  bool at_end() const { return p_ == end_; }
+
+  [[noreturn]] void fail(const std::string &msg) const {
+    throw std::runtime_error("checkpoint " + path_ + ": " + msg);
+  }
+
+private:
+  const char *p_;
+  const char *end_;
+  const std::string &path_;
+};
+
+} // namespace
+
+uint64_t node_order_hash(const node_table &nodes) {
+  // FNV-1a over the ids
+  uint64_t h = 14695981039346656037ull;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    h = (h ^ static_cast<uint32_t>(nodes.orig_id(i))) * 1099511628211ull;
+  }
+  return h;
+}
+
+bool write_checkpoint(const std::string &path, const sa_checkpoint &c) {
+  std::string buf(magic, sizeof(magic));
+  put<uint32_t>(buf, checkpoint_version);
+  put<int32_t>(buf, c.n_nodes);
+  put<int32_t>(buf, c.capacity);
+  put<uint64_t>(buf, c.node_order);
+  put<int32_t>(buf, c.reheat);
+  put<int32_t>(buf, c.stag_left);
+  put<int32_t>(buf, c.current.size());
+  put<int64_t>(buf, c.iterations);
+  put<double>(buf, c.temp);
+  put<double>(buf, c.cost);
+  put<double>(buf, c.best_cost);
+  for (const uint64_t w : c.rng_state) {
+    put<uint64_t>(buf, w);
+  }
+  put_routes(buf, c.current);
+  put_routes(buf, c.best);
+
+  const std::string tmp = path + ".tmp";
+  FILE *out = std::fopen(tmp.c_str(), "wb");
+  if (out == nullptr) {
+    return false;
+  }
+  const bool written = std::fwrite(buf.data(), 1, buf.size(), out) ==
+                       buf.size();
+  if (std::fclose(out) != 0 || !written) {
+    std::remove(tmp.c_str());
+    return false;
+  }
+  return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+sa_checkpoint read_checkpoint(const std::string &path) {
+  const mapped_file file(path);
+  if (!file.error().empty()) {
+    throw std::runtime_error("cannot read " + path + ": " + file.error());
+  }
+  reader in(file, path);
+  char head[sizeof(magic)] = {};
+  for (char &ch : head) {
+    ch = in.get<char>();
+  }
+  if (std::memcmp(head, magic, sizeof(magic)) != 0) {
+    in.fail("not a checkpoint");
+  }
+  const uint32_t version = in.get<uint32_t>();
+  if (version != checkpoint_version) {
+    in.fail("version " + std::to_string(version) + ", expected " +
+            std::to_string(checkpoint_version));
+  }
+  sa_checkpoint c;
+  c.n_nodes = in.get<int32_t>();
+  c.capacity = in.get<int32_t>();
+  c.node_order = in.get<uint64_t>();
+  c.reheat = in.get<int32_t>();
+  c.stag_left = in.get<int32_t>();
+  const int n_routes = in.get<int32_t>();
+  if (c.n_nodes < 1 || n_routes < 0) {
+    in.fail("bad header");
+  }
+  c.iterations = in.get<int64_t>();
+  c.temp = in.get<double>();
+  c.cost = in.get<double>();
+  c.best_cost = in.get<double>();
+  for (auto &w : c.rng_state) {
+    w = in.get<uint64_t>();
+  }
+  c.current = in.routes(n_routes, c.n_nodes, c.capacity);
+  c.best = in.routes(n_routes, c.n_nodes, c.capacity);
+  if (!in.at_end()) {
+    in.fail("trailing bytes");
+  }
+  return c;
+}
@@ -0,0 +1,50 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "utils.hpp"
+
+// Where an annealing run stands: both route sets, the loop counters, the
+// temperature and the RNG state. A run resumed from a checkpoint makes
+// the same moves the run that wrote it would have made, unless it shares
+// its best with other runs (sa_sol::share_best).
+struct sa_checkpoint {
+  int n_nodes = 0;
+  int capacity = 0;
+  uint64_t node_order = 0; // node_order_hash of the problem
+  int reheat = 0;    // reheats started, the current one included
+  int stag_left = 0; // iterations left before the reheat, unless improving
+  long long iterations = 0;
+  double temp = 0;
+  double cost = 0; // of current, as summed by the run
+  double best_cost = 0;
+  uint64_t rng_state[4] = {};
+  std::vector<veh> current;
+  std::vector<veh> best;
+};
+
+// Binary layout, native byte order:
+//   "CVRPCKPT", uint32 version, int32 n_nodes, capacity, uint64 node_order,
+//   int32 reheat, stag_left, n_routes, int64 iterations, double temp, cost,
+//   best_cost, uint64 rng_state[4],
+// then for current and for best: n_routes of (int32 load, int32 customers,
+// double cost), followed by the customer ids of all routes, int32 each.
+// About 4 bytes per customer and 16 per route, for each set.
+constexpr uint32_t checkpoint_version = 2;
+
+// Hash of the nodes' original ids in their order, which tells apart the
+// same problem renumbered along different curves (renumber.hpp).
+uint64_t node_order_hash(const node_table &nodes);
+
+// Writes to a temporary file renamed over path, so an interrupted write
+// leaves the previous checkpoint intact. Returns false on I/O errors.
+bool write_checkpoint(const std::string &path, const sa_checkpoint &c);
+
+// Maps the file and decodes it. Throws std::runtime_error when the file
+// cannot be read, is not a checkpoint, has another version or is cut short.
+sa_checkpoint read_checkpoint(const std::string &path);
+
+#endif // CHECKPOINT_HPP
@@ -0,0 +1,331 @@
+#include "decompose.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <numeric>
+
+#include "greedy.hpp"
+#include "neighbors.hpp"
+#include "pool.hpp"
+#include "rng.hpp"
+
+namespace {
+
+// Cheapest backend whose matrix stays under 64 MB, so that regions solved
+// side by side do not add up to much.
+dist_kind region_kind(const size_t n) {
+  const double budget = 64e6;
+  if (n * n * sizeof(double) <= budget) {
+    return dist_kind::flat;
+  }
+  if (n * n / 2 * sizeof(float) <= budget) {
+    return dist_kind::compact;
+  }
+  return dist_kind::implicit;
+}
+
+double total_cost(const std::vector<veh> &vehicles) {
+  return std::accumulate(
+      std::begin(vehicles), std::end(vehicles), 0.0,
+      [](const double sum, const veh &v) { return sum + v.cost_; });
+}
+
+// Customers sorted by angle around the depot, starting after the widest
+// empty sector so that no cluster is cut by the wrap-around, then cut
+// into n_regions runs of about equal demand.
+void sweep(const sol &s, const int n_regions, std::vector<int> &region) {
+  const dist_mtx &d = s.dist_mtx_;
+  const int n = s.nodes_.size();
+  std::vector<std::pair<double, int>> order;
+  for (int i = 1; i < n; ++i) {
+    order.emplace_back(std::atan2(d.y(i) - d.y(0), d.x(i) - d.x(0)), i);
+  }
+  std::sort(order.begin(), order.end());
+  const size_t m = order.size();
+  size_t first = 0;
+  double widest = -1;
+  for (size_t k = 0; k < m; ++k) {
+    const double next = k + 1 < m ? order[k + 1].first
+                                  : order[0].first + 2 * M_PI;
+    if (next - order[k].first > widest) {
+      widest = next - order[k].first;
+      first = (k + 1) % m;
+    }
+  }
+  std::rotate(order.begin(), order.begin() + first, order.end());
+
+  double total = 0;
+  for (const auto &[angle, i] : order) {
+    total += s.nodes_[i].demand_;
+  }
+  // split on customer counts when nothing has demand
+  const bool by_demand = total > 0;
+  if (!by_demand) {
+    total = m;
+  }
+  double seen = 0;
+  for (const auto &[angle, i] : order) {
+    const double w = by_demand ? s.nodes_[i].demand_ : 1;
+    region[i] = std::min(n_regions - 1,
+                         static_cast<int>((seen + w / 2) * n_regions / total));
+    seen += w;
+  }
+}
+
+// Lloyd's iterations from k-means++ seeds. Clusters left empty are dropped
+// by the caller.
+void kmeans(const sol &s, const int k, const uint64_t seed,
+            std::vector<int> &region) {
+  const dist_mtx &d = s.dist_mtx_;
+  const int n = s.nodes_.size();
+  rng g(seed);
+  std::vector<double> cx, cy;
+  std::vector<double> closest(n, std::numeric_limits<double>::max());
+  auto add_center = [&](const int i) {
+    cx.push_back(d.x(i));
+    cy.push_back(d.y(i));
+    for (int j = 1; j < n; ++j) {
+      const double dx = d.x(j) - d.x(i), dy = d.y(j) - d.y(i);
+      closest[j] = std::min(closest[j], dx * dx + dy * dy);
+    }
+  };
+  add_center(1 + g.below(n - 1));
+  while (static_cast<int>(cx.size()) < k) {
+    // next seed with probability proportional to the squared distance
+    const double sum = std::accumulate(closest.begin() + 1, closest.end(), 0.0);
+    double target = g.uniform() * sum;
+    int pick = n - 1;
+    for (int j = 1; j < n; ++j) {
+      target -= closest[j];
+      if (target < 0) {
+        pick = j;
+        break;
+      }
+    }
+    add_center(pick);
+  }
+
+  std::vector<double> sx(k), sy(k);
+  std::vector<int> count(k);
+  for (int iter = 0; iter < 50; ++iter) {
+    bool changed = false;
+    for (int j = 1; j < n; ++j) {
+      int best = 0;
+      double best_d = std::numeric_limits<double>::max();
+      for (int c = 0; c < k; ++c) {
+        const double dx = d.x(j) - cx[c], dy = d.y(j) - cy[c];
+        if (dx * dx + dy * dy < best_d) {
+          best_d = dx * dx + dy * dy;
+          best = c;
+        }
+      }
+      changed |= region[j] != best;
+      region[j] = best;
+    }
+    if (!changed) {
+      break;
+    }
+    std::fill(sx.begin(), sx.end(), 0);
+    std::fill(sy.begin(), sy.end(), 0);
+    std::fill(count.begin(), count.end(), 0);
+    for (int j = 1; j < n; ++j) {
+      sx[region[j]] += d.x(j);
+      sy[region[j]] += d.y(j);
+      count[region[j]]++;
+    }
+    for (int c = 0; c < k; ++c) {
+      if (count[c] > 0) {
+        cx[c] = sx[c] / count[c];
+        cy[c] = sy[c] / count[c];
+      }
+    }
+  }
+}
+
+// Nearest-neighbour start of a region with at least n_vehicles vehicles,
+// adding one at a time until every customer is routed. One vehicle per
+// customer always does, as no demand exceeds the capacity (checked by
+// dc_sol).
+nn_sol region_start(const node_table &nodes, const dist_mtx &dist,
+                    const int capacity, int n_vehicles) {
+  const int n_customers = static_cast<int>(nodes.size()) - 1;
+  while (true) {
+    std::vector<veh> vehicles;
+    for (int i = 0; i < n_vehicles; ++i) {
+      vehicles.emplace_back(i, capacity, capacity);
+      vehicles.back().nodes_.push_back(0);
+    }
+    nn_sol nn(nodes, vehicles, dist);
+    nn.create_init_sol();
+    if (nn.check_sol_val() || n_vehicles >= n_customers) {
+      return nn;
+    }
+    n_vehicles++;
+  }
+}
+
+} // namespace
+
+sa_params hybrid_sa_params(const double init_temp) {
+  sa_params params;
+  params.stag_limit = 50000;
+  params.init_temp = init_temp;
+  params.cooling_rate = 0.9899;
+  return params;
+}
+
+dc_sol::dc_sol(const prob &p, const dc_params &params)
+    : sol(p), params_(params), fleet_(p.vehicles_.size()) {
+  if (!dist_mtx_.euclidean()) {
+    std::cout << "Decomposition needs node coordinates. Exiting." << '\n';
+    exit(1);
+  }
+  for (size_t i = 1; i < nodes_.size(); ++i) {
+    if (nodes_[i].demand_ > capacity_) {
+      std::cout << "Customer " << nodes_.orig_id(i)
+                << " has more demand than a vehicle holds. Exiting." << '\n';
+      exit(1);
+    }
+  }
+}
+
+int dc_sol::partition() {
+  const int n = nodes_.size();
+  const int n_regions =
+      std::clamp((n - 1 + params_.region_size / 2) /
+                     std::max(1, params_.region_size),
+                 1, std::max(1, n - 1));
+  region_.assign(n, -1);
+  if (params_.partition == partition_kind::sweep) {
+    sweep(*this, n_regions, region_);
+  } else {
+    kmeans(*this, n_regions, params_.sub.seed, region_);
+  }
+  // renumber the regions in use 0, 1, ...
+  std::vector<int> id(n_regions, -1);
+  int used = 0;
+  for (int i = 1; i < n; ++i) {
+    if (id[region_[i]] < 0) {
+      id[region_[i]] = used++;
+    }
+    region_[i] = id[region_[i]];
+  }
+  return used;
+}
+
+void dc_sol::run() {
+  const int n = nodes_.size();
+  const int n_regions = partition();
+  std::vector<std::vector<int>> members(n_regions);
+  std::vector<double> demand(n_regions, 0);
+  double total_demand = 0;
+  for (int i = 1; i < n; ++i) {
+    members[region_[i]].push_back(i);
+    demand[region_[i]] += nodes_[i].demand_;
+    total_demand += nodes_[i].demand_;
+  }
+
+  // Each region is a problem of its own with the depot at 0 and its
+  // customers at 1..m; members maps the local ids back.
+  const int n_vehicles = vehicles_.size();
+  std::vector<std::vector<veh>> solved(n_regions);
+  std::vector<long long> iterations(n_regions);
+  {
+    work_pool pool(params_.n_threads);
+    for (int r = 0; r < n_regions; ++r) {
+      pool.submit([this, r, &members, &demand, &solved, &iterations,
+                   total_demand, n_vehicles] {
+        const std::vector<int> &ids = members[r];
+        std::vector<nd> nodes{nd(depot_.x_, depot_.y_, 0, 0)};
+        std::vector<double> xs{dist_mtx_.x(0)}, ys{dist_mtx_.y(0)};
+        for (size_t k = 0; k < ids.size(); ++k) {
+          const nd &c = nodes_[ids[k]];
+          nodes.emplace_back(c.x_, c.y_, k + 1, c.demand_);
+          xs.push_back(dist_mtx_.x(ids[k]));
+          ys.push_back(dist_mtx_.y(ids[k]));
+        }
+        const dist_mtx dist(xs, ys, region_kind(nodes.size()));
+        const int share =
+            total_demand > 0
+                ? std::ceil(n_vehicles * demand[r] / total_demand)
+                : 1;
+        const int needed = std::ceil(demand[r] / capacity_);
+        const nn_sol start =
+            region_start(nodes, dist, capacity_, std::max({1, share, needed}));
+        sa_params params = params_.sub;
+        params.seed += r;
+        sa_sol sa(start, params);
+        sa.anneal();
+        iterations[r] = sa.iterations();
+        solved[r] = sa.vehicles_;
+        for (auto &v : solved[r]) {
+          for (auto &id : v.nodes_) {
+            id = id == 0 ? 0 : ids[id - 1];
+          }
+        }
+      });
+    }
+    pool.wait();
+  }
+  iterations_ = std::accumulate(iterations.begin(), iterations.end(), 0LL);
+
+  vehicles_.clear();
+  for (const auto &vehicles : solved) {
+    for (veh v : vehicles) {
+      v.id_ = vehicles_.size();
+      v.calc_cost(dist_mtx_);
+      vehicles_.push_back(std::move(v));
+    }
+  }
+  for (int i = 1; i < n; ++i) {
+    mark_routed(i);
+  }
+
+  // Border customers have a candidate neighbour in another region; only
+  // moves starting from them are proposed by the repair pass.
+  std::vector<int> border;
+  if (n_regions > 1) {
+    const nbr_list nbrs(nodes_, dist_mtx_, params_.repair.n_nbrs);
+    for (int i = 1; i < n; ++i) {
+      const int *row = nbrs.of(i);
+      for (int k = 0; k < nbrs.k(); ++k) {
+        if (row[k] != 0 && region_[row[k]] != region_[i]) {
+          border.push_back(i);
+          break;
+        }
+      }
+    }
+  }
+  n_border_ = border.size();
+  if (border.empty() || params_.repair_iters <= 0) {
+    return;
+  }
+  sa_params params = params_.repair;
+  if (!params.limits.anytime()) {
+    params.limits.iterations =
+        static_cast<long long>(params_.repair_iters) * border.size();
+  }
+  sa_sol repair(static_cast<const sol &>(*this), params);
+  repair.set_focus(std::move(border));
+  repair.anneal();
+  iterations_ += repair.iterations();
+  vehicles_ = repair.vehicles_;
+}
+
+void dc_sol::solve() {
+  run();
+  int n_regions = 0;
+  for (const int r : region_) {
+    n_regions = std::max(n_regions, r + 1);
+  }
+  int n_used = 0;
+  for (const auto &v : vehicles_) {
+    n_used += v.nodes_.size() > 2;
+  }
+  std::cout << "Regions: " << n_regions << ", border customers: " << n_border_
+            << ", routes: " << n_used << " (fleet " << fleet_ << ")" << '\n';
+  std::cout << "Cost: " << total_cost(vehicles_) << '\n';
+  std::cout << "Solution valid: " << check_sol_val() << '\n';
+}
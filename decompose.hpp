@@ -0,0 +1,73 @@
+#ifndef DECOMPOSE_HPP
+#define DECOMPOSE_HPP
+
+#include <thread>
+#include <vector>
+
+#include "simulated_annealing.hpp"
+#include "utils.hpp"
+
+// How customers are grouped into regions.
+enum class partition_kind {
+  sweep, // polar angle around the depot, cut into equal-demand sectors
+  kmeans // Lloyd's k-means on the coordinates, k-means++ seeding
+};
+
+// The annealing settings of the hybrid solver (stagnation after 50000
+// iterations, cooling 0.9899) at the given start temperature.
+sa_params hybrid_sa_params(double init_temp);
+
+// Settings of a cluster-first solve.
+struct dc_params {
+  partition_kind partition = partition_kind::sweep;
+  int region_size = 1000; // customers per region, on average
+  int n_threads = std::thread::hardware_concurrency();
+  // per-region search; region r runs with seed sub.seed + r
+  sa_params sub = hybrid_sa_params(50);
+  // boundary repair over the merged solution, iteration budget
+  // repair_iters * (border customers) unless repair.limits sets one, no
+  // repair when repair_iters is 0
+  sa_params repair = hybrid_sa_params(5);
+  int repair_iters = 200;
+};
+
+// Cluster-first, route-second for very large Euclidean instances. The
+// customers are split into regions of about region_size, each region is
+// solved on its own (nearest neighbour, then sa_sol) on a work_pool, and
+// the routes are merged. Vehicles are shared out in proportion to region
+// demand, with more added to a region whose start needs them, so the
+// routes can outnumber p's fleet (see fleet()). A last annealing pass over
+// the whole instance proposes moves only from border customers, those
+// with a candidate neighbour in another region.
+class dc_sol : public sol {
+public:
+  dc_sol(const prob &p, const dc_params &params = dc_params());
+
+  void solve() override;
+
+  // Partitions, solves and repairs without printing anything.
+  void run();
+
+  // Region of every node after run(), -1 for the depot.
+  const std::vector<int> &regions() const { return region_; }
+
+  // Customers the repair pass started from.
+  int border_size() const { return n_border_; }
+
+  // Vehicles of the problem; run() may use more.
+  int fleet() const { return fleet_; }
+
+  // Search iterations of the regions and the repair pass.
+  long long iterations() const { return iterations_; }
+
+private:
+  dc_params params_;
+  std::vector<int> region_;
+  int n_border_ = 0;
+  int fleet_ = 0;
+  long long iterations_ = 0;
+
+  int partition();
+};
+
+#endif // DECOMPOSE_HPP
@@ -0,0 +1,141 @@
+#include "distance.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#include "kernels.hpp"
+
+dist_kind parse_dist_kind(const std::string &name) {
+  if (name == "compact") {
+    return dist_kind::compact;
+  }
+  if (name == "implicit") {
+    return dist_kind::implicit;
+  }
+  if (name != "flat") {
+    throw std::runtime_error("unknown distance backend '" + name +
+                             "', expected flat, compact or implicit");
+  }
+  return dist_kind::flat;
+}
+
+std::string to_string(const dist_kind kind) {
+  switch (kind) {
+  case dist_kind::compact:
+    return "compact";
+  case dist_kind::implicit:
+    return "implicit";
+  default:
+    return "flat";
+  }
+}
+
+namespace {
+
+// Runs fill(i) for every row i, rows interleaved over the hardware threads
+// so that the triangular backend stays balanced.
+template <typename F> void for_each_row(const size_t n, F fill) {
+  const size_t n_threads = std::max<size_t>(
+      1, std::min<size_t>(std::thread::hardware_concurrency(), n / 256));
+  if (n_threads == 1) {
+    for (size_t i = 0; i < n; ++i) {
+      fill(i);
+    }
+    return;
+  }
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < n_threads; ++t) {
+    workers.emplace_back([=, &fill] {
+      for (size_t i = t; i < n; i += n_threads) {
+        fill(i);
+      }
+    });
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+}
+
+} // namespace
+
+dist_mtx::dist_mtx(const std::vector<double> &xs,
+                   const std::vector<double> &ys, const dist_kind kind)
+    : kind_(kind), n_(xs.size()) {
+  // x coordinates followed by y coordinates, kept for every backend
+  auto coords = std::make_shared<std::vector<double>>(xs);
+  coords->insert(coords->end(), ys.begin(), ys.end());
+  xs_ = coords->data();
+  ys_ = coords->data() + n_;
+  coords_ = coords;
+
+  if (kind_ == dist_kind::flat) {
+    auto buf = std::make_shared<std::vector<double>>(n_ * n_);
+    double *out = buf->data();
+    for_each_row(n_, [&](const size_t i) {
+      euclid_row(xs_, ys_, n_, xs_[i], ys_[i], out + i * n_);
+    });
+    flat_ = buf->data();
+    flat_buf_ = buf;
+  } else if (kind_ == dist_kind::compact) {
+    auto buf = std::make_shared<std::vector<float>>(n_ * (n_ + 1) / 2);
+    float *out = buf->data();
+    for_each_row(n_, [&](const size_t i) {
+      thread_local std::vector<double> tmp;
+      tmp.resize(i + 1);
+      euclid_row(xs_, ys_, i + 1, xs_[i], ys_[i], tmp.data());
+      std::copy(tmp.begin(), tmp.end(), out + tri_idx(i, 0));
+    });
+    tri_ = buf->data();
+    tri_buf_ = buf;
+  }
+}
+
+dist_mtx::dist_mtx(const std::vector<double> &lower, const size_t n,
+                   const dist_kind kind)
+    : kind_(kind == dist_kind::compact ? kind : dist_kind::flat), n_(n) {
+  if (kind_ == dist_kind::flat) {
+    auto buf = std::make_shared<std::vector<double>>(n_ * n_);
+    double *out = buf->data();
+    for_each_row(n_, [&](const size_t i) {
+      for (size_t j = 0; j < n_; ++j) {
+        out[i * n_ + j] = lower[i >= j ? tri_idx(i, j) : tri_idx(j, i)];
+      }
+    });
+    flat_ = buf->data();
+    flat_buf_ = buf;
+  } else {
+    auto buf =
+        std::make_shared<std::vector<float>>(lower.begin(), lower.end());
+    tri_ = buf->data();
+    tri_buf_ = buf;
+  }
+}
+
+const double *dist_mtx::row(const int i, std::vector<double> &scratch) const {
+  if (kind_ == dist_kind::flat) {
+    return flat_ + static_cast<size_t>(i) * n_;
+  }
+  scratch.resize(n_);
+  if (kind_ == dist_kind::compact) {
+    const float *head = tri_ + tri_idx(i, 0);
+    std::copy(head, head + i + 1, scratch.begin());
+    for (size_t j = i + 1; j < n_; ++j) {
+      scratch[j] = tri_[tri_idx(j, i)];
+    }
+  } else {
+    euclid_row(xs_, ys_, n_, xs_[i], ys_[i], scratch.data());
+  }
+  return scratch.data();
+}
+
+size_t dist_mtx::bytes() const {
+  size_t total = coords_ ? coords_->size() * sizeof(double) : 0;
+  if (flat_buf_) {
+    total += flat_buf_->size() * sizeof(double);
+  }
+  if (tri_buf_) {
+    total += tri_buf_->size() * sizeof(float);
+  }
+  return total;
+}
@@ -0,0 +1,121 @@
+#ifndef DISTANCE_HPP
+#define DISTANCE_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Storage backend of a distance oracle:
+//  flat     - full n*n row-major double buffer,
+//  compact  - lower triangle (diagonal included) stored as float,
+//  implicit - no buffer, Euclidean distance computed from the coordinates.
+enum class dist_kind { flat, compact, implicit };
+
+// Throws std::runtime_error on a name other than flat, compact or implicit.
+dist_kind parse_dist_kind(const std::string &name);
+
+std::string to_string(dist_kind kind);
+
+class dist_mtx {
+public:
+  dist_mtx() = default;
+
+  dist_mtx(const std::vector<double> &xs, const std::vector<double> &ys,
+           dist_kind kind = dist_kind::flat);
+
+  // Explicit weights: lower triangle of a symmetric n*n matrix, diagonal
+  // included, row by row. Without coordinates the implicit backend is not
+  // available and flat is used instead.
+  dist_mtx(const std::vector<double> &lower, size_t n,
+           dist_kind kind = dist_kind::flat);
+
+  // Copies share the (immutable) underlying buffer.
+  dist_mtx(const dist_mtx &d) = default;
+
+  dist_mtx &operator=(const dist_mtx &d) = default;
+
+  double operator()(const int i, const int j) const {
+    switch (kind_) {
+    case dist_kind::flat:
+      return flat_[static_cast<size_t>(i) * n_ + j];
+    case dist_kind::compact:
+      return i >= j ? tri_[tri_idx(i, j)] : tri_[tri_idx(j, i)];
+    default: {
+      const double dx = xs_[i] - xs_[j];
+      const double dy = ys_[i] - ys_[j];
+      return std::sqrt(dx * dx + dy * dy);
+    }
+    }
+  }
+
+  // Row i as a contiguous array. The flat backend returns its own storage,
+  // the other backends fill and return scratch.
+  const double *row(int i, std::vector<double> &scratch) const;
+
+  size_t size() const { return n_; }
+
+  dist_kind kind() const { return kind_; }
+
+  // Whether distances are Euclidean over node coordinates, which the
+  // spatial grid relies on. False for explicit weights.
+  bool euclidean() const { return xs_ != nullptr; }
+
+  // Coordinates the distances are computed from, euclidean() only.
+  double x(const int i) const { return xs_[i]; }
+
+  double y(const int i) const { return ys_[i]; }
+
+  // Heap memory held by the backend, coordinates included.
+  size_t bytes() const;
+
+private:
+  template <dist_kind K> friend class dist_view;
+
+  static size_t tri_idx(const size_t i, const size_t j) {
+    return i * (i + 1) / 2 + j;
+  }
+
+  dist_kind kind_ = dist_kind::flat;
+  size_t n_ = 0;
+  const double *flat_ = nullptr;
+  const float *tri_ = nullptr;
+  const double *xs_ = nullptr;
+  const double *ys_ = nullptr;
+  std::shared_ptr<const std::vector<double>> coords_;
+  std::shared_ptr<const std::vector<double>> flat_buf_;
+  std::shared_ptr<const std::vector<float>> tri_buf_;
+};
+
+// A dist_mtx whose backend K is fixed at compile time, for loops compiled
+// once per backend (see anneal.hpp): a lookup is the bare load, or the
+// square root, without the switch. Returns the same values as the matrix
+// it views, which must be of kind K and outlive the view.
+template <dist_kind K> class dist_view {
+public:
+  explicit dist_view(const dist_mtx &d)
+      : n_(d.n_), flat_(d.flat_), tri_(d.tri_), xs_(d.xs_), ys_(d.ys_) {}
+
+  double operator()(const int i, const int j) const {
+    if constexpr (K == dist_kind::flat) {
+      return flat_[static_cast<size_t>(i) * n_ + j];
+    } else if constexpr (K == dist_kind::compact) {
+      return i >= j ? tri_[dist_mtx::tri_idx(i, j)]
+                    : tri_[dist_mtx::tri_idx(j, i)];
+    } else {
+      const double dx = xs_[i] - xs_[j];
+      const double dy = ys_[i] - ys_[j];
+      return std::sqrt(dx * dx + dy * dy);
+    }
+  }
+
+private:
+  size_t n_;
+  const double *flat_;
+  const float *tri_;
+  const double *xs_;
+  const double *ys_;
+};
+
+#endif // DISTANCE_HPP
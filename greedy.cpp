@@ -3,37 +3,23 @@
 #include <iostream>
 #include <numeric>
 
-nn_sol::nn_sol(const std::vector<nd> &nodes, const std::vector<veh> &vehicles,
-               const std::vector<std::vector<double>> &distanceMatrix)
+nn_sol::nn_sol(const node_table &nodes, const std::vector<veh> &vehicles,
+               const dist_mtx &distanceMatrix)
     : sol(nodes, vehicles, distanceMatrix) {}
 
 nn_sol::nn_sol(const prob &p) : sol(p.nodes_, p.vehicles_, p.dist_mtx_) {}
 
 void nn_sol::solve() {
-  for (auto &v : vehicles_) {
-    while (true) {
-      const auto [found, closest_node] = find_closest(v);
-      if (found && v.load_ - closest_node.demand_ >= 0) {
-        v.load_ -= closest_node.demand_;
-        v.cost_ += dist_mtx_[v.nodes_.back()][closest_node.id_];
-        v.nodes_.push_back(closest_node.id_);
-        nodes_[closest_node.id_].is_routed_ = true;
-      } else {
-        v.cost_ += dist_mtx_[v.nodes_.back()][depot_.id_];
-        v.nodes_.push_back(depot_.id_);
-        break;
-      }
-    }
-  }
+  create_init_sol();
 
   double cost = std::accumulate(
       std::begin(vehicles_), std::end(vehicles_), 0.0,
       [](const double sum, const veh &v) { return sum + v.cost_; });
   std::cout << "Cost: " << cost << '\n';
-  for (const auto &i : nodes_) {
-    if (!i.is_routed_) {
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    if (!is_routed(i)) {
       std::cout << "Unreached node: " << '\n';
-      std::cout << i << '\n';
+      std::cout << nodes_[i] << '\n';
     }
   }
 
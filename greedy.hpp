@@ -5,8 +5,8 @@
 
 class nn_sol : public sol {
 public:
-  nn_sol(const std::vector<nd> &nodes, const std::vector<veh> &vehicles,
-         const std::vector<std::vector<double>> &distanceMatrix);
+  nn_sol(const node_table &nodes, const std::vector<veh> &vehicles,
+         const dist_mtx &distanceMatrix);
 
   explicit nn_sol(const prob &p);
 
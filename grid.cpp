@@ -0,0 +1,208 @@
+#include "grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <utility>
+
+grid::grid(const dist_mtx &dist, const std::vector<nd> &nodes,
+           const std::vector<int> &members)
+    : slot_(nodes.size(), -1), xs_(nodes.size()), ys_(nodes.size()),
+      dem_(nodes.size()) {
+  for (const auto &n : nodes) {
+    xs_[n.id_] = dist.x(n.id_);
+    ys_[n.id_] = dist.y(n.id_);
+    dem_[n.id_] = n.demand_;
+  }
+  size_ = static_cast<int>(members.size());
+  if (members.empty()) {
+    start_.assign(1, 0);
+    count_.assign(1, 0);
+    min_dem_.assign(1, std::numeric_limits<int>::max());
+    return;
+  }
+
+  // bounding box, about two nodes per cell
+  double x1 = xs_[members[0]], y1 = ys_[members[0]];
+  x0_ = x1;
+  y0_ = y1;
+  for (const int id : members) {
+    x0_ = std::min(x0_, xs_[id]);
+    y0_ = std::min(y0_, ys_[id]);
+    x1 = std::max(x1, xs_[id]);
+    y1 = std::max(y1, ys_[id]);
+  }
+  const double w = std::max(x1 - x0_, 1.0);
+  const double h = std::max(y1 - y0_, 1.0);
+  side_ = std::max(std::sqrt(w * h / std::max(size_ / 2, 1)), 1e-9);
+  nx_ = static_cast<int>(w / side_) + 1;
+  ny_ = static_cast<int>(h / side_) + 1;
+
+  // counting sort of the members into cells
+  const int n_cells = nx_ * ny_;
+  start_.assign(n_cells + 1, 0);
+  count_.assign(n_cells, 0);
+  min_dem_.assign(n_cells, std::numeric_limits<int>::max());
+  for (const int id : members) {
+    const int c = cell_of(xs_[id], ys_[id]);
+    count_[c]++;
+    min_dem_[c] = std::min(min_dem_[c], dem_[id]);
+  }
+  for (int c = 0; c < n_cells; ++c) {
+    start_[c + 1] = start_[c] + count_[c];
+  }
+  ids_.resize(members.size());
+  std::vector<int> fill(start_.begin(), start_.end() - 1);
+  for (const int id : members) {
+    const int c = cell_of(xs_[id], ys_[id]);
+    slot_[id] = fill[c];
+    ids_[fill[c]++] = id;
+  }
+
+  by_dem_ = members;
+  std::stable_sort(by_dem_.begin(), by_dem_.end(),
+                   [&](const int a, const int b) { return dem_[a] < dem_[b]; });
+}
+
+int grid::cell_of(const double x, const double y) const {
+  const int cx = std::clamp(static_cast<int>((x - x0_) / side_), 0, nx_ - 1);
+  const int cy = std::clamp(static_cast<int>((y - y0_) / side_), 0, ny_ - 1);
+  return cy * nx_ + cx;
+}
+
+template <typename F>
+void grid::for_ring(const int cx, const int cy, const int r, F f) const {
+  const int xa = cx - r, xb = cx + r, ya = cy - r, yb = cy + r;
+  for (int gx = std::max(xa, 0); gx <= std::min(xb, nx_ - 1); ++gx) {
+    if (ya >= 0) {
+      f(ya * nx_ + gx);
+    }
+    if (r > 0 && yb < ny_) {
+      f(yb * nx_ + gx);
+    }
+  }
+  for (int gy = std::max(ya + 1, 0); gy <= std::min(yb - 1, ny_ - 1); ++gy) {
+    if (xa >= 0) {
+      f(gy * nx_ + xa);
+    }
+    if (r > 0 && xb < nx_) {
+      f(gy * nx_ + xb);
+    }
+  }
+}
+
+void grid::scan(const int c, const double x, const double y, const int load,
+                int &best, double &best_d) const {
+  if (count_[c] == 0 || min_dem_[c] > load) {
+    return;
+  }
+  for (int k = start_[c]; k < start_[c] + count_[c]; ++k) {
+    const int id = ids_[k];
+    if (dem_[id] > load) {
+      continue;
+    }
+    const double dx = xs_[id] - x;
+    const double dy = ys_[id] - y;
+    const double d = dx * dx + dy * dy;
+    if (d < best_d || (d == best_d && id < best)) {
+      best_d = d;
+      best = id;
+    }
+  }
+}
+
+int grid::nearest(const double x, const double y, const int load) const {
+  while (dem_head_ < by_dem_.size() && slot_[by_dem_[dem_head_]] < 0) {
+    dem_head_++;
+  }
+  if (dem_head_ == by_dem_.size() || dem_[by_dem_[dem_head_]] > load) {
+    return -1;
+  }
+
+  const int c = cell_of(x, y);
+  const int cx = c % nx_;
+  const int cy = c / nx_;
+  // distance from (x, y) to the border of its own cell
+  const double lx = x - (x0_ + cx * side_);
+  const double ly = y - (y0_ + cy * side_);
+  const double margin =
+      std::max(0.0, std::min({lx, ly, side_ - lx, side_ - ly}));
+  int best = -1;
+  double best_d = std::numeric_limits<double>::max();
+  const int max_r = std::max(nx_, ny_);
+  for (int r = 0; r <= max_r; ++r) {
+    for_ring(cx, cy, r, [&](const int cell) {
+      scan(cell, x, y, load, best, best_d);
+    });
+    // everything beyond ring r is at least r * side_ + margin away
+    const double reach = r * side_ + margin;
+    if (best >= 0 && best_d < reach * reach) {
+      break;
+    }
+  }
+  return best;
+}
+
+std::vector<int> grid::k_nearest(const double x, const double y, const int k,
+                                 const int skip) const {
+  const int c = cell_of(x, y);
+  const int cx = c % nx_;
+  const int cy = c / nx_;
+  // max-heap on (squared distance, id) holding the k best so far
+  std::priority_queue<std::pair<double, int>> heap;
+  const int max_r = std::max(nx_, ny_);
+  for (int r = 0; r <= max_r; ++r) {
+    for_ring(cx, cy, r, [&](const int cell) {
+      for (int j = start_[cell]; j < start_[cell] + count_[cell]; ++j) {
+        const int id = ids_[j];
+        if (id == skip) {
+          continue;
+        }
+        const double dx = xs_[id] - x;
+        const double dy = ys_[id] - y;
+        const std::pair<double, int> e(dx * dx + dy * dy, id);
+        if (static_cast<int>(heap.size()) < k) {
+          heap.push(e);
+        } else if (e < heap.top()) {
+          heap.pop();
+          heap.push(e);
+        }
+      }
+    });
+    // cells beyond ring r are at least r * side_ away from any point of
+    // the centre cell
+    const double reach = r * side_;
+    if (static_cast<int>(heap.size()) == k &&
+        heap.top().first < reach * reach) {
+      break;
+    }
+  }
+  std::vector<int> out(heap.size());
+  for (int i = static_cast<int>(heap.size()) - 1; i >= 0; --i) {
+    out[i] = heap.top().second;
+    heap.pop();
+  }
+  return out;
+}
+
+void grid::erase(const int id) {
+  const int k = slot_[id];
+  if (k < 0) {
+    return;
+  }
+  const int c = cell_of(xs_[id], ys_[id]);
+  const int last = start_[c] + count_[c] - 1;
+  ids_[k] = ids_[last];
+  slot_[ids_[k]] = k;
+  slot_[id] = -1;
+  count_[c]--;
+  size_--;
+  if (dem_[id] == min_dem_[c]) {
+    min_dem_[c] = std::numeric_limits<int>::max();
+    for (int j = start_[c]; j < start_[c] + count_[c]; ++j) {
+      min_dem_[c] = std::min(min_dem_[c], dem_[ids_[j]]);
+    }
+  }
+}
@@ -0,0 +1,56 @@
+#ifndef GRID_HPP
+#define GRID_HPP
+
+#include <vector>
+
+#include "utils.hpp"
+
+// Uniform bucket grid over the node coordinates. Holds the members given
+// (the nodes not routed yet, say) and answers nearest-neighbour queries restricted to nodes
+// whose demand fits a given load. Nodes are removed once routed.
+class grid {
+public:
+  // Indexes the nodes whose ids are in members, at the coordinates the
+  // distances are computed from (dist.euclidean() only): the nd records
+  // hold them rounded to integers.
+  grid(const dist_mtx &dist, const std::vector<nd> &nodes,
+       const std::vector<int> &members);
+
+  // Nearest indexed node to (x, y) with demand <= load, lowest id on ties,
+  // or -1 when no indexed node fits.
+  int nearest(double x, double y, int load) const;
+
+  // The k indexed nodes nearest to (x, y), demand ignored, node skip
+  // excluded, closest first.
+  std::vector<int> k_nearest(double x, double y, int k, int skip) const;
+
+  void erase(int id);
+
+  bool contains(const int id) const { return slot_[id] >= 0; }
+
+  int size() const { return size_; }
+
+private:
+  int cell_of(double x, double y) const;
+
+  // Calls f(c) for every cell c at Chebyshev distance r from (cx, cy).
+  template <typename F> void for_ring(int cx, int cy, int r, F f) const;
+
+  // Scans the members of cell c, updating best and best_d (squared).
+  void scan(int c, double x, double y, int load, int &best,
+            double &best_d) const;
+
+  double x0_ = 0, y0_ = 0, side_ = 1;
+  int nx_ = 1, ny_ = 1;
+  int size_ = 0;
+  // members of cell c live in ids_[start_[c], start_[c] + count_[c])
+  std::vector<int> start_, count_, min_dem_, ids_;
+  std::vector<int> slot_; // position of a node in ids_, -1 once erased
+  std::vector<double> xs_, ys_;
+  std::vector<int> dem_;
+  // ids sorted by demand, used to reject queries no remaining node fits
+  std::vector<int> by_dem_;
+  mutable size_t dem_head_ = 0;
+};
+
+#endif // GRID_HPP
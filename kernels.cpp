@@ -0,0 +1,121 @@
+#include "kernels.hpp"
+
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void euclid_row(const double *xs, const double *ys, const size_t n,
+                const double x, const double y, double *out) {
+  size_t j = 0;
+#if defined(__AVX2__)
+  const __m256d vx = _mm256_set1_pd(x);
+  const __m256d vy = _mm256_set1_pd(y);
+  for (; j + 4 <= n; j += 4) {
+    const __m256d dx = _mm256_sub_pd(vx, _mm256_loadu_pd(xs + j));
+    const __m256d dy = _mm256_sub_pd(vy, _mm256_loadu_pd(ys + j));
+    const __m256d sq =
+        _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+    _mm256_storeu_pd(out + j, _mm256_sqrt_pd(sq));
+  }
+#elif defined(__SSE2__)
+  const __m128d vx = _mm_set1_pd(x);
+  const __m128d vy = _mm_set1_pd(y);
+  for (; j + 2 <= n; j += 2) {
+    const __m128d dx = _mm_sub_pd(vx, _mm_loadu_pd(xs + j));
+    const __m128d dy = _mm_sub_pd(vy, _mm_loadu_pd(ys + j));
+    const __m128d sq = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+    _mm_storeu_pd(out + j, _mm_sqrt_pd(sq));
+  }
+#endif
+  for (; j < n; ++j) {
+    const double dx = x - xs[j];
+    const double dy = y - ys[j];
+    out[j] = std::sqrt(dx * dx + dy * dy);
+  }
+}
+
+int masked_argmin(const double *row, const int *dem, const size_t n,
+                  const int load) {
+  double best = std::numeric_limits<double>::max();
+  int id = -1;
+  size_t j = 0;
+#if defined(__AVX2__)
+  if (n >= 4) {
+    // per-lane minimum and its index (kept as double, exact below 2^53)
+    __m256d vbest = _mm256_set1_pd(best);
+    __m256d vid = _mm256_set1_pd(-1);
+    __m256d vj = _mm256_setr_pd(0, 1, 2, 3);
+    const __m256d step = _mm256_set1_pd(4);
+    const __m128i vload = _mm_set1_epi32(load);
+    for (; j + 4 <= n; j += 4) {
+      const __m256d d = _mm256_loadu_pd(row + j);
+      const __m128i dm =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(dem + j));
+      const __m128i over = _mm_cmpgt_epi32(dm, vload);
+      const __m256d fits =
+          _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_xor_si128(
+              over, _mm_set1_epi32(-1))));
+      const __m256d take =
+          _mm256_and_pd(fits, _mm256_cmp_pd(d, vbest, _CMP_LT_OQ));
+      vbest = _mm256_blendv_pd(vbest, d, take);
+      vid = _mm256_blendv_pd(vid, vj, take);
+      vj = _mm256_add_pd(vj, step);
+    }
+    alignas(32) double lane_best[4];
+    alignas(32) double lane_id[4];
+    _mm256_store_pd(lane_best, vbest);
+    _mm256_store_pd(lane_id, vid);
+    for (int l = 0; l < 4; ++l) {
+      const int lid = static_cast<int>(lane_id[l]);
+      if (lid >= 0 && (lane_best[l] < best ||
+                       (lane_best[l] == best && lid < id))) {
+        best = lane_best[l];
+        id = lid;
+      }
+    }
+  }
+#elif defined(__SSE2__)
+  if (n >= 2) {
+    __m128d vbest = _mm_set1_pd(best);
+    __m128d vid = _mm_set1_pd(-1);
+    __m128d vj = _mm_setr_pd(0, 1);
+    const __m128d step = _mm_set1_pd(2);
+    const __m128i vload = _mm_set1_epi32(load);
+    for (; j + 2 <= n; j += 2) {
+      const __m128d d = _mm_loadu_pd(row + j);
+      const __m128i dm =
+          _mm_loadl_epi64(reinterpret_cast<const __m128i *>(dem + j));
+      const __m128i over = _mm_cmpgt_epi32(dm, vload);
+      const __m128d fits = _mm_castsi128_pd(_mm_unpacklo_epi32(over, over));
+      const __m128d take = _mm_andnot_pd(fits, _mm_cmplt_pd(d, vbest));
+      vbest = _mm_or_pd(_mm_and_pd(take, d), _mm_andnot_pd(take, vbest));
+      vid = _mm_or_pd(_mm_and_pd(take, vj), _mm_andnot_pd(take, vid));
+      vj = _mm_add_pd(vj, step);
+    }
+    alignas(16) double lane_best[2];
+    alignas(16) double lane_id[2];
+    _mm_store_pd(lane_best, vbest);
+    _mm_store_pd(lane_id, vid);
+    for (int l = 0; l < 2; ++l) {
+      const int lid = static_cast<int>(lane_id[l]);
+      if (lid >= 0 && (lane_best[l] < best ||
+                       (lane_best[l] == best && lid < id))) {
+        best = lane_best[l];
+        id = lid;
+      }
+    }
+  }
+#endif
+  for (; j < n; ++j) {
+    if (dem[j] <= load && row[j] < best) {
+      best = row[j];
+      id = static_cast<int>(j);
+    }
+  }
+  return id;
+}
@@ -0,0 +1,19 @@
+#ifndef KERNELS_HPP
+#define KERNELS_HPP
+
+#include <cstddef>
+
+// Vectorized inner loops. Each kernel has an AVX2 and an SSE2 path selected
+// at compile time (build with -march=native to get AVX2) and a scalar
+// fallback for other targets.
+
+// out[j] = sqrt((x - xs[j])^2 + (y - ys[j])^2) for j in [0, n).
+void euclid_row(const double *xs, const double *ys, size_t n, double x,
+                double y, double *out);
+
+// Index of the smallest row[j] with dem[j] <= load, lowest index on ties,
+// or -1 when no element qualifies. Routed nodes are expected to carry a
+// demand larger than any load so that a single compare masks them out.
+int masked_argmin(const double *row, const int *dem, size_t n, int load);
+
+#endif // KERNELS_HPP
@@ -1,29 +1,124 @@
 #include <bits/stdc++.h>
 
+#include "batch.hpp"
 #include "greedy.hpp"
+#include "parallel.hpp"
+#include "renumber.hpp"
 #include "simulated_annealing.hpp"
+#include "tsplib.hpp"
 #include "utils.hpp"
 
 int main(int argc, char **argv) {
+  if (argc >= 3 && std::string(argv[1]) == "--batch") {
+    const int n_threads =
+        argc >= 4 ? std::stoi(argv[3])
+                  : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<batch_job> jobs;
+    try {
+      jobs = read_manifest(argv[2]);
+    } catch (const std::exception &e) {
+      std::cout << "Error: " << e.what() << '\n';
+      return 1;
+    }
+    return run_batch(jobs, n_threads, std::cout) ? 1 : 0;
+  }
+
+  // --sol, --checkpoint and --resume take a value and may come anywhere
+  std::string sol_path, checkpoint_path, resume_path;
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    std::string *value = arg == "--sol"          ? &sol_path
+                         : arg == "--checkpoint" ? &checkpoint_path
+                         : arg == "--resume"     ? &resume_path
+                                                 : nullptr;
+    if (value != nullptr && i + 1 < argc) {
+      *value = argv[++i];
+    } else {
+      args.push_back(arg);
+    }
+  }
+
   std::string input_path;
   int novargs = 4;
-  if (argc >= 2) {
-    input_path = argv[1];
-    if (argc >= 3) {
-      novargs = std::stoi(argv[2]);
+  dist_kind kind = dist_kind::flat;
+  uint64_t seed = 1;
+  move_mix moves;
+  std::string trace_path;
+  curve_kind curve = curve_kind::none;
+  if (args.size() >= 1) {
+    // a malformed number or an unknown name ends the run with its error
+    try {
+      input_path = args[0];
+      if (args.size() >= 2) {
+        novargs = std::stoi(args[1]);
+      }
+      if (args.size() >= 3) {
+        kind = parse_dist_kind(args[2]);
+      }
+      if (args.size() >= 4) {
+        seed = std::stoull(args[3]);
+      }
+      if (args.size() >= 5) {
+        moves = parse_move_mix(args[4]);
+      }
+      if (args.size() >= 6) {
+        trace_path = args[5];
+      }
+      if (args.size() >= 7) {
+        curve = parse_curve_kind(args[6]);
+      }
+    } catch (const std::exception &e) {
+      std::cout << "Error: " << e.what() << '\n';
+      return 1;
     }
   }
 
   prob p('#');
   if (!input_path.empty()) {
     std::cout << "Reading from file: " << input_path << '\n';
-    p = prob(input_path, novargs);
+    try {
+      p = prob(input_path, novargs, kind);
+    } catch (const std::exception &e) {
+      std::cout << "Error: " << e.what() << '\n';
+      return 1;
+    }
+    if (curve != curve_kind::none) {
+      renumber(p, curve);
+      std::cout << "Customers renumbered along the " << to_string(curve)
+                << " curve" << '\n';
+    }
+    std::cout << "Distance backend: " << to_string(kind) << " ("
+              << p.dist_mtx_.bytes() << " bytes)" << '\n';
   } else {
-    std::cout << "Usage: ./cvrp input.vrp veh_num" << '\n';
+    std::cout << "Usage: ./main input.vrp veh_num [flat|compact|implicit] "
+                 "[seed] [relocate,swap,2opt,2opt*,oropt|all] [trace.csv] "
+                 "[none|hilbert|morton]"
+              << '\n';
+    std::cout << "       [--sol best.sol] [--checkpoint sa.ckpt] "
+                 "[--resume sa.ckpt]"
+              << '\n';
+    std::cout << "  --sol writes the cheapest valid solution in CVRPLIB "
+                 "format; --checkpoint"
+              << '\n';
+    std::cout << "  and --resume save and restore the SA run's state (the "
+                 "same instance,"
+              << '\n';
+    std::cout << "  vehicles and curve)" << '\n';
+    std::cout << "       ./main --batch manifest [threads]" << '\n';
     return 1;
   }
 
   std::vector<std::pair<double, double>> results;
+  // routes of the cheapest valid solution, for --sol
+  std::vector<std::vector<int>> best_routes;
+  double best_cost = std::numeric_limits<double>::max();
+  auto keep_best = [&](const sol &s, const double cost) {
+    if (s.check_sol_val() && cost < best_cost) {
+      best_cost = cost;
+      best_routes = s.get_routes();
+    }
+  };
 
   {
     std::cout << "NN: " << '\n';
@@ -33,29 +128,47 @@ int main(int argc, char **argv) {
     nn.solve();
     auto end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = end - start;
-    std::cout << "Elapsed time: " << elapsed.count() * 1e9 << " ns" << '\n';
+    std::cout << "Elapsed time: " << elapsed.count() << " s" << '\n';
     std::cout << '\n';
 
     double cost = std::accumulate(
         std::begin(nn.vehicles_), std::end(nn.vehicles_), 0.0,
         [](const double sum, const veh &v) { return sum + v.cost_; });
     results.push_back(std::make_pair(cost, elapsed.count()));
+    keep_best(nn, cost);
   }
 
   {
     std::cout << "SA: " << '\n';
-    sa_sol sa(p, 500000, 50000, 0.9899, 20);
+    sa_sol sa(p, 500000, 50000, 0.9899, 20, 20, seed);
+    sa.set_moves(moves);
+    if (!trace_path.empty()) {
+      sa.trace_to(trace_path);
+    }
+    if (!checkpoint_path.empty()) {
+      sa.checkpoint_to(checkpoint_path);
+    }
+    if (!resume_path.empty()) {
+      try {
+        sa.resume_from(resume_path);
+      } catch (const std::exception &e) {
+        std::cout << "Error: " << e.what() << '\n';
+        return 1;
+      }
+      std::cout << "Resuming from " << resume_path << '\n';
+    }
     auto start = std::chrono::high_resolution_clock::now();
     sa.solve();
     auto end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = end - start;
-    std::cout << "Elapsed time: " << elapsed.count() * 1e9 << " ns" << '\n';
+    std::cout << "Elapsed time: " << elapsed.count() << " s" << '\n';
     std::cout << '\n';
 
     double cost = std::accumulate(
         std::begin(sa.vehicles_), std::end(sa.vehicles_), 0.0,
         [](const double sum, const veh &v) { return sum + v.cost_; });
     results.push_back(std::make_pair(cost, elapsed.count()));
+    keep_best(sa, cost);
   }
 
   {
@@ -63,18 +176,57 @@ int main(int argc, char **argv) {
     nn_sol hyb(p);
     hyb.solve();
     auto s3 = hyb;
-    sa_sol sa4hyb(s3, 500000, 50, 0.9899, 20);
+    sa_sol sa4hyb(s3, 500000, 50, 0.9899, 20, 20, seed);
+    sa4hyb.set_moves(moves);
     auto start = std::chrono::high_resolution_clock::now();
     sa4hyb.solve();
     auto end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed = end - start;
-    std::cout << "Elapsed time: " << elapsed.count() * 1e9 << " ns" << '\n';
+    std::cout << "Elapsed time: " << elapsed.count() << " s" << '\n';
     std::cout << '\n';
 
     double cost = std::accumulate(
         std::begin(sa4hyb.vehicles_), std::end(sa4hyb.vehicles_), 0.0,
         [](const double sum, const veh &v) { return sum + v.cost_; });
     results.push_back(std::make_pair(cost, elapsed.count()));
+    keep_best(sa4hyb, cost);
+  }
+
+  {
+    const int n_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Multi-start (" << n_threads << " threads): " << '\n';
+    nn_sol start(p);
+    start.solve();
+    sa_params params;
+    params.init_temp = 50;
+    params.cooling_rate = 0.9899;
+    params.seed = seed;
+    params.moves = moves;
+    ms_sol ms(start, n_threads, params);
+    auto start_time = std::chrono::high_resolution_clock::now();
+    ms.solve();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end - start_time;
+    std::cout << "Elapsed time: " << elapsed.count() << " s" << '\n';
+    std::cout << '\n';
+
+    double cost = std::accumulate(
+        std::begin(ms.vehicles_), std::end(ms.vehicles_), 0.0,
+        [](const double sum, const veh &v) { return sum + v.cost_; });
+    results.push_back(std::make_pair(cost, elapsed.count()));
+    keep_best(ms, cost);
+  }
+
+  if (!sol_path.empty()) {
+    if (best_routes.empty()) {
+      std::cout << "No valid solution to write to " << sol_path << '\n';
+    } else if (!write_cvrplib_sol(sol_path, best_routes, best_cost)) {
+      std::cout << "Error: cannot write " << sol_path << '\n';
+      return 1;
+    } else {
+      std::cout << "Best solution (" << best_cost << ") written to "
+                << sol_path << '\n';
+    }
   }
 
   double prec = 2;
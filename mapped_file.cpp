@@ -0,0 +1,39 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+mapped_file::mapped_file(const std::string &path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    error_ = std::strerror(errno);
+    return;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    error_ = std::strerror(errno);
+  } else if (st.st_size == 0) {
+    error_ = "empty file";
+  } else {
+    void *p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      error_ = std::strerror(errno);
+    } else {
+      ::madvise(p, st.st_size, MADV_SEQUENTIAL);
+      data_ = static_cast<const char *>(p);
+      size_ = st.st_size;
+    }
+  }
+  ::close(fd);
+}
+
+mapped_file::~mapped_file() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<char *>(data_), size_);
+  }
+}
@@ -0,0 +1,33 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+// Read-only mapping of a whole file.
+class mapped_file {
+public:
+  explicit mapped_file(const std::string &path);
+
+  mapped_file(const mapped_file &) = delete;
+
+  mapped_file &operator=(const mapped_file &) = delete;
+
+  ~mapped_file();
+
+  const char *begin() const { return data_; }
+
+  const char *end() const { return data_ + size_; }
+
+  size_t size() const { return size_; }
+
+  // why the file could not be mapped, empty on success
+  const std::string &error() const { return error_; }
+
+private:
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+  std::string error_;
+};
+
+#endif // MAPPED_FILE_HPP
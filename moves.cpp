@@ -0,0 +1,58 @@
+#include "moves.hpp"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+move_mix parse_move_mix(const std::string &spec) {
+  move_mix mix;
+  for (auto &w : mix.weight) {
+    w = 0;
+  }
+  std::istringstream iss(spec);
+  std::string item;
+  while (std::getline(iss, item, ',')) {
+    double weight = 1;
+    const size_t colon = item.find(':');
+    if (colon != std::string::npos) {
+      const std::string text = item.substr(colon + 1);
+      size_t used = 0;
+      try {
+        weight = std::stod(text, &used);
+      } catch (const std::exception &) {
+        used = 0;
+      }
+      if (used == 0 || used != text.size() || !(weight >= 0) ||
+          std::isinf(weight)) {
+        throw std::runtime_error("bad move weight '" + text + "' in '" +
+                                 item + "'");
+      }
+      item = item.substr(0, colon);
+    }
+    if (item == "all") {
+      for (auto &w : mix.weight) {
+        w = weight;
+      }
+    } else if (item == "relocate") {
+      mix.weight[mv_relocate] = weight;
+    } else if (item == "swap") {
+      mix.weight[mv_swap] = weight;
+    } else if (item == "2opt") {
+      mix.weight[mv_two_opt] = weight;
+    } else if (item == "2opt*") {
+      mix.weight[mv_two_opt_star] = weight;
+    } else if (item == "oropt") {
+      mix.weight[mv_or_opt] = weight;
+    } else {
+      throw std::runtime_error("unknown move '" + item +
+                               "', expected relocate, swap, 2opt, 2opt*, "
+                               "oropt or all");
+    }
+  }
+  for (const double w : mix.weight) {
+    if (w > 0) {
+      return mix;
+    }
+  }
+  return move_mix();
+}
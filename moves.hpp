@@ -0,0 +1,383 @@
+#ifndef MOVES_HPP
+#define MOVES_HPP
+
+#include <string>
+#include <vector>
+
+#include "neighbors.hpp"
+#include "rng.hpp"
+#include "routes.hpp"
+#include "trace.hpp"
+#include "utils.hpp"
+
+// Read-only data every move needs. Dist is dist_mtx or one of its
+// fixed-backend dist_views.
+template <typename Dist> struct basic_move_ctx {
+  const std::vector<nd> &nodes;
+  const Dist &dist;
+  // candidate neighbours, all nodes when empty
+  const nbr_list &nbrs;
+  int capacity;
+  // capacity rejections are counted here when built with CVRP_TRACE
+  search_stats *stats = nullptr;
+  // customers moves start from, all of them when null
+  const std::vector<int> *focus = nullptr;
+};
+
+using move_ctx = basic_move_ctx<dist_mtx>;
+
+// Neighbourhood operators. They evaluate cost and capacity from the links
+// and the route loads; 2opt* also reads the prefix demands and lengths
+// of routes, which cost O(route length) after the route changed.
+enum move_kind {
+  mv_relocate,     // one customer next to a neighbour
+  mv_swap,         // two customers exchange places
+  mv_two_opt,      // reverse a path inside one route
+  mv_two_opt_star, // exchange the tails of two routes
+  mv_or_opt,       // a path of 2-3 customers next to a neighbour
+  n_move_kinds
+};
+
+// Relative frequency of every operator in a run.
+struct move_mix {
+  double weight[n_move_kinds] = {1, 0, 0, 0, 0};
+
+  static move_mix all() {
+    move_mix mix;
+    for (auto &w : mix.weight) {
+      w = 1;
+    }
+    return mix;
+  }
+
+  // Draws an operator; consumes no randomness when only one is enabled.
+  int pick(rng &g) const {
+    double total = 0;
+    int single = -1;
+    for (int k = 0; k < n_move_kinds; ++k) {
+      if (weight[k] > 0) {
+        single = total == 0 ? k : -1;
+        total += weight[k];
+      }
+    }
+    if (single >= 0) {
+      return single;
+    }
+    double u = g.uniform() * total;
+    for (int k = 0; k < n_move_kinds; ++k) {
+      if (weight[k] > 0 && (u -= weight[k]) < 0) {
+        return k;
+      }
+    }
+    return mv_relocate;
+  }
+};
+
+// Parses a comma separated list of operators, each optionally followed by
+// ":weight", e.g. "relocate:2,swap,2opt,2opt*,oropt". "all" enables every
+// operator. Throws std::runtime_error on an unknown name or a weight that
+// is not a non-negative number; no weight above 0 means relocate only.
+move_mix parse_move_mix(const std::string &spec);
+
+namespace detail {
+
+// A random routed customer (of the focus set if any), or 0.
+template <typename Ctx>
+inline int pick_customer(const Ctx &ctx, const routes &rt, rng &g) {
+  const int c = ctx.focus != nullptr
+                    ? (*ctx.focus)[g.below(ctx.focus->size())]
+                    : 1 + g.below(ctx.nodes.size() - 1);
+  return rt.route(c) >= 0 ? c : 0;
+}
+
+// A candidate neighbour of c (possibly the depot).
+template <typename Ctx>
+inline int pick_nbr(const Ctx &ctx, const int c, rng &g) {
+  return ctx.nbrs.empty() ? g.below(ctx.nodes.size())
+                          : ctx.nbrs.of(c)[g.below(ctx.nbrs.k())];
+}
+
+// Picks an insertion point next to neighbour m: sets route r and the node a
+// to insert after (0 for the front). Returns false if m is unrouted.
+inline bool pick_slot(const routes &rt, const int m, rng &g, int &r, int &a) {
+  if (m == 0) {
+    r = g.below(rt.n_routes());
+    a = g.below(2) ? 0 : rt.tail(r);
+    return true;
+  }
+  if (rt.route(m) < 0) {
+    return false;
+  }
+  r = rt.route(m);
+  a = g.below(2) ? m : rt.prev(m); // after or before m
+  return true;
+}
+
+} // namespace detail
+
+// Proposes relocating a random customer right before or after one of its
+// candidate neighbours (to the front or back of a random route when the
+// neighbour is the depot). The move is applied when it respects capacity and
+// accept(delta) holds; delta is the change of the total cost. Returns whether
+// the move was applied, with its delta in applied_delta.
+template <typename Ctx, typename Accept>
+inline bool relocate_move(const Ctx &ctx, routes &rt, rng &g, Accept accept,
+                   double &applied_delta) {
+  const int c = detail::pick_customer(ctx, rt, g);
+  if (c == 0) {
+    return false;
+  }
+  const int r1 = rt.route(c);
+  const int m = detail::pick_nbr(ctx, c, g);
+  int r2 = 0;
+  int a = 0;
+  if (!detail::pick_slot(rt, m, g, r2, a) || a == c ||
+      (r1 == r2 && a == rt.prev(c))) {
+    return false;
+  }
+  const auto &d = ctx.dist;
+  const int prev = rt.prev(c);
+  const int next_c = rt.next(c);
+  const int next_a = a != 0 ? rt.next(a) : rt.head(r2);
+  const double cost_reduction = d(prev, next_c) - d(prev, c) - d(c, next_c);
+  const double cost_increase = d(a, c) + d(c, next_a) - d(a, next_a);
+  const double delta = cost_increase + cost_reduction;
+  const int demand = ctx.nodes[c].demand_;
+  if (rt.load(r2) - demand < 0 && r1 != r2) {
+    CVRP_COUNT(ctx.stats, capacity);
+    return false;
+  }
+  if (!accept(delta)) {
+    return false;
+  }
+  rt.add_load(r1, demand);
+  rt.add_load(r2, -demand);
+  rt.add_cost(r1, cost_reduction);
+  rt.add_cost(r2, cost_increase);
+  rt.relocate(c, r2, a);
+  applied_delta = delta;
+  return true;
+}
+
+// Exchanges a random customer with one of its candidate neighbours.
+template <typename Ctx, typename Accept>
+inline bool swap_move(const Ctx &ctx, routes &rt, rng &g, Accept accept,
+               double &applied_delta) {
+  const int c = detail::pick_customer(ctx, rt, g);
+  if (c == 0) {
+    return false;
+  }
+  const int m = detail::pick_nbr(ctx, c, g);
+  if (m == 0 || m == c || rt.route(m) < 0) {
+    return false;
+  }
+  const auto &d = ctx.dist;
+  const int r1 = rt.route(c);
+  const int r2 = rt.route(m);
+  double delta1 = 0; // change on r1
+  double delta2 = 0; // change on r2
+  if (rt.next(c) == m || rt.next(m) == c) {
+    // x y adjacent in this order: p x y n -> p y x n
+    const int x = rt.next(c) == m ? c : m;
+    const int y = x == c ? m : c;
+    const int p = rt.prev(x);
+    const int n = rt.next(y);
+    delta1 = d(p, y) + d(x, n) - d(p, x) - d(y, n);
+  } else {
+    const int pc = rt.prev(c), nc = rt.next(c);
+    const int pm = rt.prev(m), nm = rt.next(m);
+    delta1 = d(pc, m) + d(m, nc) - d(pc, c) - d(c, nc);
+    delta2 = d(pm, c) + d(c, nm) - d(pm, m) - d(m, nm);
+  }
+  const int dc = ctx.nodes[c].demand_;
+  const int dm = ctx.nodes[m].demand_;
+  if (r1 != r2 && (rt.load(r1) + dc - dm < 0 || rt.load(r2) + dm - dc < 0)) {
+    CVRP_COUNT(ctx.stats, capacity);
+    return false;
+  }
+  const double delta = delta1 + delta2;
+  if (!accept(delta)) {
+    return false;
+  }
+  if (r1 != r2) {
+    rt.add_load(r1, dc - dm);
+    rt.add_load(r2, dm - dc);
+  }
+  rt.add_cost(r1, delta1);
+  rt.add_cost(r2, delta2);
+  rt.swap(c, m);
+  applied_delta = delta;
+  return true;
+}
+
+// Intra-route 2-opt: replaces edges (c, next c) and (m, next m) of one route
+// by (c, m) and (next c, next m), reversing the path in between.
+template <typename Ctx, typename Accept>
+inline bool two_opt_move(const Ctx &ctx, routes &rt, rng &g, Accept accept,
+                  double &applied_delta) {
+  const int c = detail::pick_customer(ctx, rt, g);
+  if (c == 0) {
+    return false;
+  }
+  const int m = detail::pick_nbr(ctx, c, g);
+  const int r = rt.route(c);
+  if (m == 0 || m == c || rt.route(m) != r) {
+    return false;
+  }
+  const int nc = rt.next(c);
+  const int nm = rt.next(m);
+  if (nc == m || nm == c) {
+    return false;
+  }
+  const auto &d = ctx.dist;
+  const double delta = d(c, m) + d(nc, nm) - d(c, nc) - d(m, nm);
+  if (!accept(delta)) {
+    return false;
+  }
+  if (rt.pos(c) < rt.pos(m)) {
+    rt.reverse(nc, m);
+  } else {
+    rt.reverse(nm, c);
+  }
+  rt.add_cost(r, delta);
+  applied_delta = delta;
+  return true;
+}
+
+// Inter-route 2-opt*: c's route continues with the tail after m and m's
+// route with the tail after c.
+template <typename Ctx, typename Accept>
+inline bool two_opt_star_move(const Ctx &ctx, routes &rt, rng &g, Accept accept,
+                       double &applied_delta) {
+  const int c = detail::pick_customer(ctx, rt, g);
+  if (c == 0) {
+    return false;
+  }
+  const int m = detail::pick_nbr(ctx, c, g);
+  if (m == 0 || rt.route(m) < 0 || rt.route(m) == rt.route(c)) {
+    return false;
+  }
+  const int r1 = rt.route(c);
+  const int r2 = rt.route(m);
+  const int total1 = ctx.capacity - rt.load(r1);
+  const int total2 = ctx.capacity - rt.load(r2);
+  const int head1 = rt.demand_upto(c);
+  const int head2 = rt.demand_upto(m);
+  const int new1 = head1 + total2 - head2;
+  const int new2 = head2 + total1 - head1;
+  if (new1 > ctx.capacity || new2 > ctx.capacity) {
+    CVRP_COUNT(ctx.stats, capacity);
+    return false;
+  }
+  const auto &d = ctx.dist;
+  const int nc = rt.next(c);
+  const int nm = rt.next(m);
+  const double delta = d(c, nm) + d(m, nc) - d(c, nc) - d(m, nm);
+  if (!accept(delta)) {
+    return false;
+  }
+  // lengths of the tails from nc and nm back to the depot, from the prefix
+  // caches rather than walking the routes
+  const double tail1 = rt.cost(r1) - rt.dist_upto(c, d) - d(c, nc);
+  const double tail2 = rt.cost(r2) - rt.dist_upto(m, d) - d(m, nm);
+  rt.add_load(r1, total1 - new1);
+  rt.add_load(r2, total2 - new2);
+  rt.add_cost(r1, tail2 - tail1 + d(c, nm) - d(c, nc));
+  rt.add_cost(r2, tail1 - tail2 + d(m, nc) - d(m, nm));
+  rt.swap_tails(c, m);
+  applied_delta = delta;
+  return true;
+}
+
+// Or-opt: moves the path of 2 or 3 customers starting at a random customer
+// next to one of its candidate neighbours, in either orientation.
+template <typename Ctx, typename Accept>
+inline bool or_opt_move(const Ctx &ctx, routes &rt, rng &g, Accept accept,
+                 double &applied_delta) {
+  const int c = detail::pick_customer(ctx, rt, g);
+  if (c == 0) {
+    return false;
+  }
+  const int len = 2 + g.below(2);
+  int seg[3] = {c, 0, 0};
+  int demand = ctx.nodes[c].demand_;
+  for (int i = 1; i < len; ++i) {
+    seg[i] = rt.next(seg[i - 1]);
+    if (seg[i] == 0) {
+      return false;
+    }
+    demand += ctx.nodes[seg[i]].demand_;
+  }
+  const int last = seg[len - 1];
+  const int r1 = rt.route(c);
+  const int m = detail::pick_nbr(ctx, c, g);
+  int r2 = 0;
+  int a = 0;
+  if (!detail::pick_slot(rt, m, g, r2, a)) {
+    return false;
+  }
+  for (int i = 0; i < len; ++i) {
+    if (a == seg[i]) {
+      return false;
+    }
+  }
+  if (r1 == r2 && a == rt.prev(c)) {
+    return false;
+  }
+  const bool reversed = g.below(2);
+  const auto &d = ctx.dist;
+  const int prev = rt.prev(c);
+  const int next_l = rt.next(last);
+  const int b = a != 0 ? rt.next(a) : rt.head(r2);
+  const int first_in = reversed ? last : c;
+  const int last_in = reversed ? c : last;
+  // the inner edges of the path travel with it to route r2
+  double inner = 0;
+  for (int i = 1; i < len; ++i) {
+    inner += d(seg[i - 1], seg[i]);
+  }
+  const double cost_reduction =
+      d(prev, next_l) - d(prev, c) - d(last, next_l) - inner;
+  const double cost_increase =
+      d(a, first_in) + d(last_in, b) - d(a, b) + inner;
+  const double delta = cost_increase + cost_reduction;
+  if (r1 != r2 && rt.load(r2) - demand < 0) {
+    CVRP_COUNT(ctx.stats, capacity);
+    return false;
+  }
+  if (!accept(delta)) {
+    return false;
+  }
+  rt.add_load(r1, demand);
+  rt.add_load(r2, -demand);
+  rt.add_cost(r1, cost_reduction);
+  rt.add_cost(r2, cost_increase);
+  int after = a;
+  for (int i = 0; i < len; ++i) {
+    const int node = seg[reversed ? len - 1 - i : i];
+    rt.relocate(node, r2, after);
+    after = node;
+  }
+  applied_delta = delta;
+  return true;
+}
+
+// Runs one proposal of operator kind.
+template <typename Ctx, typename Accept>
+inline bool apply_move(const int kind, const Ctx &ctx, routes &rt, rng &g,
+                Accept accept, double &applied_delta) {
+  switch (kind) {
+  case mv_swap:
+    return swap_move(ctx, rt, g, accept, applied_delta);
+  case mv_two_opt:
+    return two_opt_move(ctx, rt, g, accept, applied_delta);
+  case mv_two_opt_star:
+    return two_opt_star_move(ctx, rt, g, accept, applied_delta);
+  case mv_or_opt:
+    return or_opt_move(ctx, rt, g, accept, applied_delta);
+  default:
+    return relocate_move(ctx, rt, g, accept, applied_delta);
+  }
+}
+
+#endif // MOVES_HPP
@@ -0,0 +1,43 @@
+#include "neighbors.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+#include "grid.hpp"
+
+nbr_list::nbr_list(const std::vector<nd> &nodes, const dist_mtx &dist,
+                   const int k) {
+  const int n = static_cast<int>(nodes.size());
+  k_ = std::max(0, std::min(k, n - 1));
+  if (k_ == 0) {
+    return;
+  }
+  auto ids = std::make_shared<std::vector<int>>(static_cast<size_t>(n) * k_);
+  ids_ = ids->data();
+  buf_ = ids;
+  if (!dist.euclidean()) {
+    std::vector<double> scratch;
+    std::vector<int> order(n);
+    for (int i = 0; i < n; ++i) {
+      const double *row = dist.row(i, scratch);
+      std::iota(order.begin(), order.end(), 0);
+      std::swap(order[i], order[n - 1]);
+      std::partial_sort(order.begin(), order.begin() + k_, order.end() - 1,
+                        [&](const int a, const int b) {
+                          return row[a] < row[b] || (row[a] == row[b] && a < b);
+                        });
+      std::copy(order.begin(), order.begin() + k_,
+                ids->begin() + static_cast<size_t>(i) * k_);
+    }
+    return;
+  }
+  // index every node
+  std::vector<int> all(n);
+  std::iota(all.begin(), all.end(), 0);
+  const grid g(dist, nodes, all);
+  for (int i = 0; i < n; ++i) {
+    const auto near = g.k_nearest(dist.x(i), dist.y(i), k_, i);
+    std::copy(near.begin(), near.end(),
+              ids->begin() + static_cast<size_t>(i) * k_);
+  }
+}
@@ -0,0 +1,33 @@
+#ifndef NEIGHBORS_HPP
+#define NEIGHBORS_HPP
+
+#include <memory>
+#include <vector>
+
+#include "utils.hpp"
+
+// Granular candidate lists: the k nearest nodes of every node (depot
+// included as a candidate), closest first, stored row by row. Euclidean
+// instances are searched on a grid, explicit ones by scanning the rows.
+class nbr_list {
+public:
+  nbr_list() = default;
+
+  nbr_list(const std::vector<nd> &nodes, const dist_mtx &dist, int k);
+
+  const int *of(const int i) const {
+    return ids_ + static_cast<size_t>(i) * k_;
+  }
+
+  int k() const { return k_; }
+
+  bool empty() const { return k_ == 0; }
+
+private:
+  int k_ = 0;
+  const int *ids_ = nullptr;
+  // copies share the (immutable) lists
+  std::shared_ptr<const std::vector<int>> buf_;
+};
+
+#endif // NEIGHBORS_HPP
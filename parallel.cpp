@@ -0,0 +1,81 @@
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <thread>
+
+namespace {
+
+std::vector<sa_params> seeded(const int n_threads, const sa_params &base) {
+  std::vector<sa_params> workers(std::max(n_threads, 1), base);
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i].seed = base.seed + i;
+  }
+  return workers;
+}
+
+double total_cost(const std::vector<veh> &vehicles) {
+  return std::accumulate(
+      std::begin(vehicles), std::end(vehicles), 0.0,
+      [](const double sum, const veh &v) { return sum + v.cost_; });
+}
+
+} // namespace
+
+ms_sol::ms_sol(const sol &start, std::vector<sa_params> workers,
+               const double restart_gap)
+    : sol(start), workers_(std::move(workers)), restart_gap_(restart_gap) {
+  if (!check_sol_val()) {
+    std::cout << "The input solution is invalid. Exiting." << '\n';
+    exit(0);
+  }
+}
+
+ms_sol::ms_sol(const sol &start, const int n_threads, const sa_params &base,
+               const double restart_gap)
+    : ms_sol(start, seeded(n_threads, base), restart_gap) {}
+
+ms_sol::ms_sol(const prob &p, const int n_threads, const sa_params &base,
+               const double restart_gap)
+    : sol(p), workers_(seeded(n_threads, base)), restart_gap_(restart_gap) {
+  create_init_sol();
+  if (!check_sol_val()) {
+    std::cout << "The input solution is invalid. Exiting." << '\n';
+    exit(0);
+  }
+}
+
+void ms_sol::solve() {
+  incumbent shared_best;
+  std::vector<std::unique_ptr<sa_sol>> runs(workers_.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    threads.emplace_back([&, i] {
+      runs[i] = std::make_unique<sa_sol>(static_cast<const sol &>(*this),
+                                         workers_[i]);
+      runs[i]->share_best(&shared_best, restart_gap_);
+      runs[i]->anneal();
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  const sa_sol *best = nullptr;
+  for (const auto &run : runs) {
+    if (run->check_sol_val() &&
+        (best == nullptr ||
+         total_cost(run->vehicles_) < total_cost(best->vehicles_))) {
+      best = run.get();
+    }
+  }
+  if (best != nullptr) {
+    vehicles_ = best->vehicles_;
+  }
+
+  std::cout << "Cost: " << total_cost(vehicles_) << '\n';
+  std::cout << "Solution valid: " << check_sol_val() << '\n';
+}
@@ -0,0 +1,36 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <vector>
+
+#include "simulated_annealing.hpp"
+#include "utils.hpp"
+
+// Multi-start simulated annealing: independent sa_sol searches from a common
+// starting solution, one per thread, each with its own settings and seed.
+// Workers share their best cost lock-free and their best routes at limit
+// checks (every check_every iterations); a worker whose best since its last
+// restart is more than restart_gap above the shared cost restarts from the
+// shared routes at its next check or reheat. The best valid solution over
+// all workers is kept.
+class ms_sol : public sol {
+public:
+  ms_sol(const sol &start, std::vector<sa_params> workers,
+         double restart_gap = 0.05);
+
+  // n_threads copies of base with seeds base.seed, base.seed + 1, ...
+  ms_sol(const sol &start, int n_threads, const sa_params &base = sa_params(),
+         double restart_gap = 0.05);
+
+  // Starts from sol::create_init_sol.
+  ms_sol(const prob &p, int n_threads, const sa_params &base = sa_params(),
+         double restart_gap = 0.05);
+
+  void solve() override;
+
+private:
+  std::vector<sa_params> workers_;
+  double restart_gap_;
+};
+
+#endif // PARALLEL_HPP
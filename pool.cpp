@@ -0,0 +1,106 @@
+#include "pool.hpp"
+
+#include <algorithm>
+
+namespace {
+
+// pool and index of the worker running on this thread
+thread_local const work_pool *this_pool = nullptr;
+thread_local int this_worker = -1;
+
+} // namespace
+
+work_pool::work_pool(const int n_threads) {
+  const int n = std::max(1, n_threads);
+  for (int i = 0; i < n; ++i) {
+    queues_.push_back(std::make_unique<task_queue>());
+  }
+  for (int i = 0; i < n; ++i) {
+    threads_.emplace_back([this, i] { run(i); });
+  }
+}
+
+work_pool::~work_pool() {
+  {
+    std::lock_guard<std::mutex> lock(m_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto &t : threads_) {
+    t.join();
+  }
+}
+
+void work_pool::submit(std::function<void()> task) {
+  const int n = size();
+  const int target = this_pool == this ? this_worker : next_++ % n;
+  {
+    std::lock_guard<std::mutex> lock(queues_[target]->m);
+    queues_[target]->tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_);
+    queued_++;
+    pending_++;
+  }
+  wake_.notify_one();
+}
+
+void work_pool::wait() {
+  std::unique_lock<std::mutex> lock(m_);
+  done_.wait(lock, [this] { return pending_ == 0; });
+}
+
+bool work_pool::try_pop(const int self, std::function<void()> &task) {
+  const int n = size();
+  {
+    task_queue &own = *queues_[self];
+    std::lock_guard<std::mutex> lock(own.m);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+  for (int k = 1; k < n; ++k) {
+    task_queue &victim = *queues_[(self + k) % n];
+    std::lock_guard<std::mutex> lock(victim.m);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void work_pool::run(const int self) {
+  this_pool = this;
+  this_worker = self;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_);
+      wake_.wait(lock, [this] { return stop_ || queued_ > 0; });
+      if (queued_ == 0) {
+        return; // stopping and nothing left
+      }
+    }
+    std::function<void()> task;
+    if (!try_pop(self, task)) {
+      continue; // another worker got there first
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_);
+      queued_--;
+    }
+    task();
+    bool idle = false;
+    {
+      std::lock_guard<std::mutex> lock(m_);
+      idle = --pending_ == 0;
+    }
+    if (idle) {
+      done_.notify_all();
+    }
+  }
+}
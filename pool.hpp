@@ -0,0 +1,60 @@
+#ifndef POOL_HPP
+#define POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size thread pool with one task deque per worker. A worker pops
+// from the back of its own deque and, when that is empty, steals from the
+// front of the others', so uneven tasks spread over the idle threads. A
+// task runs start to finish on one thread, which allocates (and first
+// touches) everything the task builds. Tasks submitted from inside a task
+// go to the submitting worker's own deque.
+class work_pool {
+public:
+  explicit work_pool(int n_threads = std::thread::hardware_concurrency());
+
+  // Finishes the queued tasks, then joins the workers.
+  ~work_pool();
+
+  work_pool(const work_pool &) = delete;
+
+  work_pool &operator=(const work_pool &) = delete;
+
+  void submit(std::function<void()> task);
+
+  // Blocks until every submitted task has finished. Not to be called from
+  // a task.
+  void wait();
+
+  int size() const { return static_cast<int>(threads_.size()); }
+
+private:
+  struct task_queue {
+    std::mutex m;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  // Own back first, then the fronts of the other queues.
+  bool try_pop(int self, std::function<void()> &task);
+
+  void run(int self);
+
+  std::vector<std::unique_ptr<task_queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::mutex m_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  int queued_ = 0;  // tasks sitting in the queues, guarded by m_
+  int pending_ = 0; // submitted and not finished, guarded by m_
+  bool stop_ = false;
+  std::atomic<unsigned> next_{0};
+};
+
+#endif // POOL_HPP
@@ -0,0 +1,129 @@
+#include "renumber.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+
+curve_kind parse_curve_kind(const std::string &name) {
+  if (name == "hilbert") {
+    return curve_kind::hilbert;
+  }
+  if (name == "morton") {
+    return curve_kind::morton;
+  }
+  if (name != "none") {
+    throw std::runtime_error("unknown curve '" + name +
+                             "', expected none, hilbert or morton");
+  }
+  return curve_kind::none;
+}
+
+std::string to_string(const curve_kind kind) {
+  switch (kind) {
+  case curve_kind::hilbert:
+    return "hilbert";
+  case curve_kind::morton:
+    return "morton";
+  default:
+    return "none";
+  }
+}
+
+namespace {
+
+constexpr int curve_bits = 16;
+
+// Position of cell (x, y) along the Hilbert curve over a
+// 2^curve_bits square.
+uint64_t hilbert_index(uint32_t x, uint32_t y) {
+  const uint32_t side = 1u << curve_bits;
+  uint64_t d = 0;
+  for (uint32_t s = side / 2; s > 0; s /= 2) {
+    const uint32_t rx = (x & s) > 0;
+    const uint32_t ry = (y & s) > 0;
+    d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+    // rotate the quadrant so the curve inside it starts where it enters
+    if (ry == 0) {
+      if (rx == 1) {
+        x = side - 1 - x;
+        y = side - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return d;
+}
+
+// The bits of x spread to the even positions.
+uint64_t spread_bits(uint64_t x) {
+  x = (x | (x << 8)) & 0x00ff00ffu;
+  x = (x | (x << 4)) & 0x0f0f0f0fu;
+  x = (x | (x << 2)) & 0x33333333u;
+  x = (x | (x << 1)) & 0x55555555u;
+  return x;
+}
+
+// Position of cell (x, y) along the Morton (Z-order) curve.
+uint64_t morton_index(const uint32_t x, const uint32_t y) {
+  return spread_bits(x) | (spread_bits(y) << 1);
+}
+
+} // namespace
+
+std::vector<int> curve_order(const dist_mtx &dist, const curve_kind kind) {
+  const int n = dist.size();
+  std::vector<int> order(n);
+  std::iota(order.begin(), order.end(), 0);
+  if (kind == curve_kind::none || !dist.euclidean() || n < 3) {
+    return order;
+  }
+  double x0 = dist.x(0), x1 = x0, y0 = dist.y(0), y1 = y0;
+  for (int i = 1; i < n; ++i) {
+    x0 = std::min(x0, dist.x(i));
+    x1 = std::max(x1, dist.x(i));
+    y0 = std::min(y0, dist.y(i));
+    y1 = std::max(y1, dist.y(i));
+  }
+  // the bounding square onto the curve's grid, aspect ratio kept
+  const double side = std::max({x1 - x0, y1 - y0, 1e-9});
+  const double scale = ((1u << curve_bits) - 1) / side;
+  std::vector<uint64_t> key(n);
+  for (int i = 1; i < n; ++i) {
+    const auto cx = static_cast<uint32_t>((dist.x(i) - x0) * scale);
+    const auto cy = static_cast<uint32_t>((dist.y(i) - y0) * scale);
+    key[i] = kind == curve_kind::hilbert ? hilbert_index(cx, cy)
+                                         : morton_index(cx, cy);
+  }
+  std::stable_sort(order.begin() + 1, order.end(),
+                   [&key](const int a, const int b) { return key[a] < key[b]; });
+  return order;
+}
+
+void renumber(prob &p, const curve_kind kind) {
+  if (kind == curve_kind::none || !p.dist_mtx_.euclidean()) {
+    return;
+  }
+  const std::vector<int> order = curve_order(p.dist_mtx_, kind);
+  const int n = order.size();
+  std::vector<nd> nodes;
+  std::vector<int> orig_ids(n);
+  std::vector<double> xs(n), ys(n);
+  nodes.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    const int old = order[i];
+    const nd &node = p.nodes_[old];
+    nodes.emplace_back(node.x_, node.y_, i, node.demand_);
+    orig_ids[i] = p.nodes_.orig_id(old);
+    // the matrix's own coordinates, so distances are the same as before
+    xs[i] = p.dist_mtx_.x(old);
+    ys[i] = p.dist_mtx_.y(old);
+  }
+  p.nodes_ = node_table(std::move(nodes), std::move(orig_ids));
+  // the old matrix goes first, so the two are never held at once (unless
+  // another copy of p still shares it)
+  const dist_kind backend = p.dist_mtx_.kind();
+  p.dist_mtx_ = dist_mtx();
+  p.dist_mtx_ = dist_mtx(xs, ys, backend);
+  p.depot_ = p.nodes_[0];
+}
@@ -0,0 +1,34 @@
+#ifndef RENUMBER_HPP
+#define RENUMBER_HPP
+
+#include <string>
+#include <vector>
+
+#include "utils.hpp"
+
+// Space-filling curves customers can be renumbered along.
+enum class curve_kind { none, hilbert, morton };
+
+// Throws std::runtime_error on a name other than none, hilbert or morton.
+curve_kind parse_curve_kind(const std::string &name);
+
+std::string to_string(curve_kind kind);
+
+// The order of the nodes along the curve through the coordinates of the
+// distance matrix (the nd records round them to integers), as
+// order[new id] = old id. The depot stays first; customers at the same
+// point keep their relative order. The identity without coordinates.
+std::vector<int> curve_order(const dist_mtx &dist, curve_kind kind);
+
+// Renumbers p's customers along the curve so that customers close in space
+// get close ids, and so sit close in the nodes, in the rows of the
+// distance matrix and in every per-node array of the solvers. The nodes
+// and the distance matrix (same backend) are rebuilt in the new order and
+// the nodes remember their original ids: sol::get_routes, set_routes and
+// print_sol speak original ids, everything else the new ones. Checkpoints
+// hold the new ids and only resume on a problem renumbered the same way.
+// Problems with explicit weights have no coordinates and are left as they
+// are, as is p for curve_kind::none.
+void renumber(prob &p, curve_kind kind);
+
+#endif // RENUMBER_HPP
@@ -0,0 +1,58 @@
+#ifndef RNG_HPP
+#define RNG_HPP
+
+#include <cstdint>
+
+// xoshiro256** generator, seeded through splitmix64. Small, fast and owned
+// by a single solver, so runs with the same seed are bit-identical.
+class rng {
+public:
+  explicit rng(uint64_t seed = 1) { reseed(seed); }
+
+  void reseed(uint64_t seed) {
+    for (auto &w : s_) {
+      seed += 0x9e3779b97f4a7c15ULL;
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      w = z ^ (z >> 31);
+    }
+  }
+
+  uint64_t next() {
+    const uint64_t result = rotl(s_[1] * 5, 7) * 9;
+    const uint64_t t = s_[1] << 17;
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+    s_[2] ^= t;
+    s_[3] = rotl(s_[3], 45);
+    return result;
+  }
+
+  // Uniform integer in [0, n) by multiply-shift, no division.
+  uint32_t below(const uint32_t n) {
+    return static_cast<uint32_t>(((next() >> 32) * n) >> 32);
+  }
+
+  // Uniform double in [0, 1).
+  double uniform() { return (next() >> 11) * 0x1.0p-53; }
+
+  const uint64_t *state() const { return s_; }
+
+  void set_state(const uint64_t *s) {
+    for (int i = 0; i < 4; ++i) {
+      s_[i] = s[i];
+    }
+  }
+
+private:
+  static uint64_t rotl(const uint64_t x, const int k) {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  uint64_t s_[4];
+};
+
+#endif // RNG_HPP
@@ -0,0 +1,169 @@
+#include "routes.hpp"
+
+#include <algorithm>
+
+routes::routes(const std::vector<veh> &vehicles, const std::vector<nd> &nodes)
+    : cost_(vehicles.size(), 0), pos_(nodes.size(), 0),
+      cum_dem_(nodes.size(), 0), cum_dist_(nodes.size(), 0),
+      stale_(vehicles.size(), stale_all) {
+  const int n_nodes = nodes.size();
+  const int n_routes = vehicles.size();
+  prev_ = n_nodes;
+  route_ = 2 * n_nodes;
+  head_ = 3 * n_nodes;
+  tail_ = head_ + n_routes;
+  size_ = tail_ + n_routes;
+  load_ = size_ + n_routes;
+  ints_.assign(load_ + n_routes, 0);
+  std::fill(ints_.begin() + route_, ints_.begin() + head_, -1);
+  auto dem = std::make_shared<std::vector<int>>(n_nodes);
+  for (int i = 0; i < n_nodes; ++i) {
+    (*dem)[i] = nodes[i].demand_;
+  }
+  dem_ = dem;
+  for (int r = 0; r < n_routes; ++r) {
+    const auto &v = vehicles[r];
+    ints_[load_ + r] = v.load_;
+    cost_[r] = v.cost_;
+    for (size_t i = 1; i + 1 < v.nodes_.size(); ++i) {
+      link_after(v.nodes_[i], r, tail(r));
+    }
+  }
+  commit();
+}
+
+void routes::unlink(const int c) {
+  const int r = route(c);
+  const int p = prev(c);
+  const int n = next(c);
+  set(p != 0 ? p : head_ + r, n);
+  set(n != 0 ? prev_ + n : tail_ + r, p);
+  set(size_ + r, size(r) - 1);
+  stale_[r] = stale_all;
+}
+
+void routes::link_after(const int c, const int r, const int a) {
+  const int b = a != 0 ? next(a) : head(r);
+  set(prev_ + c, a);
+  set(c, b);
+  set(a != 0 ? a : head_ + r, c);
+  set(b != 0 ? prev_ + b : tail_ + r, c);
+  set(route_ + c, r);
+  set(size_ + r, size(r) + 1);
+  stale_[r] = stale_all;
+}
+
+void routes::remove(const int c) {
+  unlink(c);
+  set(route_ + c, -1);
+}
+
+void routes::relocate(const int c, const int r, const int a) {
+  unlink(c);
+  link_after(c, r, a);
+}
+
+void routes::swap(const int u, const int v) {
+  if (next(u) == v) {
+    relocate(u, route(v), v);
+  } else if (next(v) == u) {
+    relocate(v, route(u), u);
+  } else {
+    // u goes right after v, then v takes u's old place
+    const int ru = route(u);
+    const int pu = prev(u);
+    relocate(u, route(v), v);
+    relocate(v, ru, pu);
+  }
+}
+
+void routes::reverse(const int first, const int last) {
+  const int r = route(first);
+  const int p = prev(first);
+  const int n = next(last);
+  for (int i = first;;) {
+    const int old_next = next(i);
+    set(i, prev(i));
+    set(prev_ + i, old_next);
+    if (i == last) {
+      break;
+    }
+    i = old_next;
+  }
+  set(first, n);
+  set(prev_ + last, p);
+  set(p != 0 ? p : head_ + r, last);
+  set(n != 0 ? prev_ + n : tail_ + r, first);
+  stale_[r] = stale_all;
+}
+
+void routes::swap_tails(const int c, const int m) {
+  const int r1 = route(c);
+  const int r2 = route(m);
+  const int nc = next(c);
+  const int nm = next(m);
+  const int t1 = tail(r1);
+  const int t2 = tail(r2);
+  int n1 = 0;
+  for (int i = nc; i != 0; i = next(i)) {
+    set(route_ + i, r2);
+    n1++;
+  }
+  int n2 = 0;
+  for (int i = nm; i != 0; i = next(i)) {
+    set(route_ + i, r1);
+    n2++;
+  }
+  set(c, nm);
+  if (nm != 0) {
+    set(prev_ + nm, c);
+  }
+  set(m, nc);
+  if (nc != 0) {
+    set(prev_ + nc, m);
+  }
+  set(tail_ + r1, nm != 0 ? t2 : c);
+  set(tail_ + r2, nc != 0 ? t1 : m);
+  set(size_ + r1, size(r1) - n1 + n2);
+  set(size_ + r2, size(r2) - n2 + n1);
+  stale_[r1] = stale_all;
+  stale_[r2] = stale_all;
+}
+
+void routes::refresh(const int r) const {
+  if (!(stale_[r] & stale_pos)) {
+    return;
+  }
+  int pos = 0;
+  int dem = 0;
+  for (int i = head(r); i != 0; i = next(i)) {
+    pos_[i] = ++pos;
+    dem += (*dem_)[i];
+    cum_dem_[i] = dem;
+  }
+  stale_[r] &= ~stale_pos;
+}
+
+void routes::rollback() {
+  for (auto it = ilog_.rbegin(); it != ilog_.rend(); ++it) {
+    ints_[it->first] = it->second;
+  }
+  for (auto it = dlog_.rbegin(); it != dlog_.rend(); ++it) {
+    cost_[it->first] = it->second;
+  }
+  std::fill(stale_.begin(), stale_.end(), stale_all);
+  commit();
+}
+
+void routes::to_vehicles(std::vector<veh> &vehicles) const {
+  for (int r = 0; r < n_routes(); ++r) {
+    auto &v = vehicles[r];
+    v.load_ = load(r);
+    v.cost_ = cost_[r];
+    v.nodes_.assign(1, 0);
+    for (int i = head(r); i != 0; i = next(i)) {
+      v.nodes_.push_back(i);
+    }
+    v.nodes_.push_back(0);
+  }
+}
@@ -0,0 +1,158 @@
+#ifndef ROUTES_HPP
+#define ROUTES_HPP
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "utils.hpp"
+
+// Routes as doubly linked lists over the node ids. The depot (node 0) is
+// shared by all routes and is not linked: a customer whose prev (next) is 0
+// starts (ends) its route, and head/tail of an empty route are 0. Moving a
+// customer is O(1) whatever the route length.
+//
+// Every write is journaled with the value it overwrote, so the state can be
+// rolled back to the last commit() without keeping a second copy around.
+//
+// Positions, prefix demands and prefix lengths are cached per route. A
+// query is O(1) while its route is unchanged; the first one after a change
+// rebuilds the route's cache in O(route length). They are not kept up to
+// date move by move: a relocation, swap or reversal shifts the prefix of
+// every stop after it, so an incremental update walks the same suffix,
+// and would do so for routes that are never queried again and once more
+// on rollback.
+class routes {
+public:
+  routes() = default;
+
+  routes(const std::vector<veh> &vehicles, const std::vector<nd> &nodes);
+
+  int next(const int i) const { return ints_[i]; }
+
+  int prev(const int i) const { return ints_[prev_ + i]; }
+
+  // route of customer i, -1 when unrouted
+  int route(const int i) const { return ints_[route_ + i]; }
+
+  int head(const int r) const { return ints_[head_ + r]; }
+
+  int tail(const int r) const { return ints_[tail_ + r]; }
+
+  int size(const int r) const { return ints_[size_ + r]; }
+
+  int n_routes() const { return static_cast<int>(cost_.size()); }
+
+  // remaining capacity, as veh::load_
+  int load(const int r) const { return ints_[load_ + r]; }
+
+  double cost(const int r) const { return cost_[r]; }
+
+  // 1-based position of customer i in its route
+  int pos(const int i) const {
+    refresh(route(i));
+    return pos_[i];
+  }
+
+  // total demand of the customers of route(i) up to and including i
+  int demand_upto(const int i) const {
+    refresh(route(i));
+    return cum_dem_[i];
+  }
+
+  // length of route(i) from the depot to i, under distances d
+  template <typename Dist> double dist_upto(const int i, const Dist &d) const {
+    const int r = route(i);
+    if (stale_[r] & stale_dist) {
+      refresh_dist(r, d);
+    }
+    return cum_dist_[i];
+  }
+
+  void add_load(const int r, const int delta) {
+    set(load_ + r, load(r) + delta);
+  }
+
+  void add_cost(const int r, const double delta) {
+    dlog_.emplace_back(r, cost_[r]);
+    cost_[r] += delta;
+  }
+
+  // Moves customer c right after node a of route r, to the front of r when
+  // a is 0.
+  void relocate(int c, int r, int a);
+
+  // Exchanges the places of customers u and v.
+  void swap(int u, int v);
+
+  // Reverses the path first..last of one route; first must come first.
+  void reverse(int first, int last);
+
+  // Exchanges the parts of the routes of c and m that follow c and m.
+  void swap_tails(int c, int m);
+
+  // Takes customer c out of its route, leaving it unrouted.
+  void remove(int c);
+
+  // Puts unrouted customer c right after node a of route r, to the front
+  // of r when a is 0.
+  void insert(const int c, const int r, const int a) { link_after(c, r, a); }
+
+  // Makes the current state the rollback point.
+  void commit() {
+    ilog_.clear();
+    dlog_.clear();
+  }
+
+  // Restores the state of the last commit().
+  void rollback();
+
+  // Number of writes since the last commit().
+  size_t journal_size() const { return ilog_.size() + dlog_.size(); }
+
+  // Writes route r back into vehicles[r] as a depot-delimited path.
+  void to_vehicles(std::vector<veh> &vehicles) const;
+
+private:
+  void unlink(int c);
+
+  void link_after(int c, int r, int a);
+
+  void set(const int slot, const int value) {
+    ilog_.emplace_back(slot, ints_[slot]);
+    ints_[slot] = value;
+  }
+
+  // bits of stale_
+  static constexpr char stale_pos = 1, stale_dist = 2, stale_all = 3;
+
+  void refresh(int r) const;
+
+  template <typename Dist> void refresh_dist(const int r, const Dist &d) const {
+    double len = 0;
+    int last = 0;
+    for (int i = head(r); i != 0; i = next(i)) {
+      len += d(last, i);
+      cum_dist_[i] = len;
+      last = i;
+    }
+    stale_[r] &= ~stale_dist;
+  }
+
+  // All integer state in one buffer: next, prev and route per node, then
+  // head, tail, size and load per route, starting at the offsets below.
+  std::vector<int> ints_;
+  int prev_ = 0, route_ = 0, head_ = 0, tail_ = 0, size_ = 0, load_ = 0;
+  std::vector<double> cost_;
+  // (slot, previous value) of every write since the last commit
+  std::vector<std::pair<int, int>> ilog_;
+  std::vector<std::pair<int, double>> dlog_;
+
+  std::shared_ptr<const std::vector<int>> dem_;
+  mutable std::vector<int> pos_, cum_dem_;
+  mutable std::vector<double> cum_dist_;
+  // which caches of each route are out of date
+  mutable std::vector<char> stale_;
+};
+
+#endif // ROUTES_HPP
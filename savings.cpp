@@ -0,0 +1,139 @@
+#include "savings.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+#include "neighbors.hpp"
+
+cw_sol::cw_sol(const node_table &nodes, const std::vector<veh> &vehicles,
+               const dist_mtx &distanceMatrix, const int n_nbrs)
+    : sol(nodes, vehicles, distanceMatrix), n_nbrs_(n_nbrs) {}
+
+cw_sol::cw_sol(const prob &p, const int n_nbrs)
+    : sol(p.nodes_, p.vehicles_, p.dist_mtx_), n_nbrs_(n_nbrs) {}
+
+void cw_sol::create_savings_sol() {
+  const int n = nodes_.size();
+  const nbr_list nbrs(nodes_, dist_mtx_, n_nbrs_);
+  const int k = nbrs.k();
+  auto listed = [&](const int i, const int j) {
+    const int *row = nbrs.of(i);
+    return std::find(row, row + k, j) != row + k;
+  };
+
+  struct saving {
+    double value;
+    int i, j;
+  };
+  std::vector<saving> pairs;
+  pairs.reserve(static_cast<size_t>(n) * k);
+  for (int i = 1; i < n; ++i) {
+    const int *row = nbrs.of(i);
+    for (int m = 0; m < k; ++m) {
+      const int j = row[m];
+      // every pair once, from the smaller id when both list each other
+      if (j == 0 || (j < i && listed(j, i))) {
+        continue;
+      }
+      const double value =
+          dist_mtx_(0, i) + dist_mtx_(0, j) - dist_mtx_(i, j);
+      if (value > 0) {
+        pairs.push_back({value, std::min(i, j), std::max(i, j)});
+      }
+    }
+  }
+  std::sort(pairs.begin(), pairs.end(),
+            [](const saving &a, const saving &b) {
+              return a.value > b.value ||
+                     (a.value == b.value &&
+                      (a.i < b.i || (a.i == b.i && a.j < b.j)));
+            });
+
+  // Routes are paths of customers: adj holds the (up to two) customers next
+  // to each one, a route end has fewer than two. Routes are merged by
+  // linking two ends, so nothing is ever reversed; a union-find over the
+  // customers keeps the route loads.
+  std::vector<int> adj(2 * static_cast<size_t>(n), 0);
+  std::vector<int> deg(n, 0);
+  std::vector<int> parent(n);
+  std::iota(parent.begin(), parent.end(), 0);
+  std::vector<int> load(n);
+  std::vector<int> size(n, 1);
+  for (int i = 0; i < n; ++i) {
+    load[i] = nodes_[i].demand_;
+  }
+  auto find = [&](int i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  };
+  for (const auto &s : pairs) {
+    if (deg[s.i] == 2 || deg[s.j] == 2) {
+      continue;
+    }
+    int ri = find(s.i);
+    int rj = find(s.j);
+    if (ri == rj || load[ri] + load[rj] > capacity_) {
+      continue;
+    }
+    adj[2 * s.i + deg[s.i]++] = s.j;
+    adj[2 * s.j + deg[s.j]++] = s.i;
+    if (size[ri] < size[rj]) {
+      std::swap(ri, rj);
+    }
+    parent[rj] = ri;
+    size[ri] += size[rj];
+    load[ri] += load[rj];
+  }
+
+  for (auto &v : vehicles_) {
+    v.nodes_.assign(2, depot_.id_);
+    v.load_ = capacity_;
+    v.cost_ = 0;
+  }
+  std::vector<bool> seen(n, false);
+  size_t r = 0;
+  for (int i = 1; i < n; ++i) {
+    if (seen[i] || deg[i] == 2) {
+      continue;
+    }
+    // walk the route from its end i
+    if (r == vehicles_.size()) {
+      vehicles_.emplace_back(r, capacity_, capacity_);
+    }
+    veh &v = vehicles_[r++];
+    v.nodes_.assign(1, depot_.id_);
+    for (int prev = 0, cur = i; cur != 0;) {
+      seen[cur] = true;
+      v.nodes_.push_back(cur);
+      v.load_ -= nodes_[cur].demand_;
+      mark_routed(cur);
+      int next = 0;
+      for (int e = 0; e < deg[cur]; ++e) {
+        if (adj[2 * cur + e] != prev) {
+          next = adj[2 * cur + e];
+        }
+      }
+      prev = cur;
+      cur = next;
+    }
+    v.nodes_.push_back(depot_.id_);
+    v.calc_cost(dist_mtx_);
+  }
+}
+
+void cw_sol::solve() {
+  create_savings_sol();
+  const double cost = std::accumulate(
+      std::begin(vehicles_), std::end(vehicles_), 0.0,
+      [](const double sum, const veh &v) { return sum + v.cost_; });
+  std::cout << "Cost: " << cost << '\n';
+  std::cout << "Routes: "
+            << std::count_if(std::begin(vehicles_), std::end(vehicles_),
+                             [](const veh &v) { return v.nodes_.size() > 2; })
+            << " of " << vehicles_.size() << " vehicles" << '\n';
+  std::cout << "Solution valid: " << check_sol_val() << '\n';
+}
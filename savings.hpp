@@ -0,0 +1,29 @@
+#ifndef SAVINGS_HPP
+#define SAVINGS_HPP
+
+#include "utils.hpp"
+
+// Clarke-Wright savings construction. Every customer starts on a route of
+// its own; pairs (i, j) are taken by decreasing saving
+// d(0, i) + d(0, j) - d(i, j) and their routes are joined end to end when
+// both are route ends and the loads fit. Only the n_nbrs nearest
+// neighbours of each customer are paired, so it runs in O(n k log(n k)).
+// The routes found fill vehicles_ in order; spare vehicles stay empty and
+// vehicles are added when there are more routes than vehicles.
+class cw_sol : public sol {
+public:
+  cw_sol(const node_table &nodes, const std::vector<veh> &vehicles,
+         const dist_mtx &distanceMatrix, int n_nbrs = 20);
+
+  explicit cw_sol(const prob &p, int n_nbrs = 20);
+
+  // Builds the routes. The result is a valid start for sa_sol(const sol &).
+  void create_savings_sol();
+
+  void solve() override;
+
+private:
+  int n_nbrs_;
+};
+
+#endif // SAVINGS_HPP
@@ -1,117 +1,163 @@
 #include "simulated_annealing.hpp"
 
-#include <cmath>
+#include <algorithm>
 #include <iostream>
 #include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 
-constexpr double mae = 0.0000000001;
-
-sa_sol::sa_sol(const std::vector<nd> &nodes, const std::vector<veh> &vehicles,
-               const std::vector<std::vector<double>> &distanceMatrix,
+sa_sol::sa_sol(const node_table &nodes, const std::vector<veh> &vehicles,
+               const dist_mtx &distanceMatrix,
                const int stag_limit, const double init_temp,
-               const double cooling_rate, const int n_reheats)
+               const double cooling_rate, const int n_reheats,
+               const int n_nbrs, const uint64_t seed)
     : sol(nodes, vehicles, distanceMatrix), stag_limit_(stag_limit),
       init_temp_(init_temp), cooling_rate_(cooling_rate),
-      n_reheats_(n_reheats) {
+      n_reheats_(n_reheats), nbrs_(nodes_, dist_mtx_, n_nbrs), rng_(seed) {
   create_init_sol();
 }
 
 sa_sol::sa_sol(const prob &p, const int stag_limit, const double init_temp,
-               const double cooling_rate, const int n_reheats)
+               const double cooling_rate, const int n_reheats,
+               const int n_nbrs, const uint64_t seed)
     : sol(p.nodes_, p.vehicles_, p.dist_mtx_), stag_limit_(stag_limit),
       init_temp_(init_temp), cooling_rate_(cooling_rate),
-      n_reheats_(n_reheats) {
+      n_reheats_(n_reheats), nbrs_(nodes_, dist_mtx_, n_nbrs), rng_(seed) {
   create_init_sol();
 }
 
 sa_sol::sa_sol(const sol &s, const int stag_limit, const double init_temp,
-               const double cooling_rate, const int n_reheats)
+               const double cooling_rate, const int n_reheats,
+               const int n_nbrs, const uint64_t seed)
     : sol(s), stag_limit_(stag_limit), init_temp_(init_temp),
-      cooling_rate_(cooling_rate), n_reheats_(n_reheats) {
+      cooling_rate_(cooling_rate), n_reheats_(n_reheats),
+      nbrs_(nodes_, dist_mtx_, n_nbrs), rng_(seed) {
   if (!s.check_sol_val()) {
     std::cout << "The input solution is invalid. Exiting." << '\n';
     exit(0);
   }
 }
 
-inline bool sa_sol::allow_move(const double delta, const double temp) {
-  return (delta < -mae) ||
-         ((static_cast<double>(rand()) / RAND_MAX) < std::exp(-delta / temp));
+sa_sol::sa_sol(const sol &s, const sa_params &params)
+    : sa_sol(s, params.stag_limit, params.init_temp, params.cooling_rate,
+             params.n_reheats, params.n_nbrs, params.seed) {
+  set_moves(params.moves);
+  set_limits(params.limits);
+}
+
+void sa_sol::share_best(incumbent *best, const double restart_gap) {
+  shared_best_ = best;
+  restart_gap_ = restart_gap;
 }
 
 void sa_sol::solve() {
-  double cost = std::accumulate(
-      std::begin(vehicles_), std::end(vehicles_), 0.0,
-      [](const double sum, const veh &v) { return sum + v.cost_; });
-  auto best_vehicles = vehicles_;
-  double best_cost = cost;
-  double current_cost = cost;
-  for (int r = 0; r < n_reheats_; r++) {
-    // std::cout << "Reheat number: " << r << '\n';
-    int stag = stag_limit_;
-    double temp = init_temp_;
-    while (--stag >= 0) {
-      temp *= cooling_rate_;
-      const int n_vehicles = vehicles_.size();
-      veh &v1 = vehicles_[rand() % n_vehicles];
-      veh &v2 = vehicles_[rand() % n_vehicles];
-      size_t cur = 0;
-      if (v1.nodes_.size() > 2) {
-        // do not select trailing zero or starting zero
-        cur = rand() % (v1.nodes_.size() - 2) + 1;
-      } else {
-        continue;
-      }
-      const size_t rep =
-          rand() % (v2.nodes_.size() - 1); // do not select trailing zero
-      if (v1.id_ == v2.id_ && (cur == rep + 1 || cur == rep)) {
-        continue;
-      }
-      const size_t prev = cur - 1;
-      const size_t next_c = cur + 1;
-      const size_t next_r = rep + 1;
-      const double cost_reduction =
-          dist_mtx_[v1.nodes_[prev]][v1.nodes_[next_c]] -
-          dist_mtx_[v1.nodes_[prev]][v1.nodes_[cur]] -
-          dist_mtx_[v1.nodes_[cur]][v1.nodes_[next_c]];
-      const double cost_increase =
-          dist_mtx_[v2.nodes_[rep]][v1.nodes_[cur]] +
-          dist_mtx_[v1.nodes_[cur]][v2.nodes_[next_r]] -
-          dist_mtx_[v2.nodes_[rep]][v2.nodes_[next_r]];
-      const double delta = cost_increase + cost_reduction;
-      if ((v2.load_ - nodes_[v1.nodes_[cur]].demand_ >= 0 ||
-           v1.id_ == v2.id_) &&
-          allow_move(delta, temp)) {
-        v1.load_ += nodes_[v1.nodes_[cur]].demand_;
-        v2.load_ -= nodes_[v1.nodes_[cur]].demand_;
-        v1.cost_ += cost_reduction;
-        v2.cost_ += cost_increase;
-        const int val = v1.nodes_[cur];
-        v1.nodes_.erase(v1.nodes_.begin() + cur);
-        if (v1.id_ == v2.id_ && cur < rep) {
-          v2.nodes_.insert(v2.nodes_.begin() + rep, val);
-        } else {
-          v2.nodes_.insert(v2.nodes_.begin() + rep + 1, val);
-        }
-        current_cost += delta;
-      }
-      if (current_cost < best_cost) {
-        stag = stag_limit_;
-        best_vehicles = vehicles_;
-        best_cost = current_cost;
-      }
-    }
-  }
-  vehicles_ = best_vehicles;
-  cost = std::accumulate(
+  anneal();
+  const double cost = std::accumulate(
       std::begin(vehicles_), std::end(vehicles_), 0.0,
       [](const double sum, const veh &v) { return sum + v.cost_; });
   std::cout << "Cost: " << cost << '\n';
-  for (const auto &i : nodes_) {
-    if (!i.is_routed_) {
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    if (!is_routed(i)) {
       std::cout << "Unreached node: " << '\n';
-      std::cout << i << '\n';
+      std::cout << nodes_[i] << '\n';
     }
   }
   std::cout << "Solution valid: " << check_sol_val() << '\n';
+  CVRP_TRACE_ON(std::cout << stats_.summary();)
+}
+
+void sa_sol::trace_to(const std::string &path, const int every) {
+#ifndef CVRP_TRACE
+  std::cout << "Built without CVRP_TRACE, no trace is written to " << path
+            << '\n';
+#endif
+  trace_path_ = path;
+  trace_every_ = every;
+}
+
+void sa_sol::checkpoint_to(const std::string &path, const long long every) {
+  checkpoint_path_ = path;
+  checkpoint_every_ = every;
+}
+
+void sa_sol::resume_from(const std::string &path) {
+  auto c = std::make_shared<sa_checkpoint>(read_checkpoint(path));
+  if (c->n_nodes != static_cast<int>(nodes_.size()) ||
+      c->capacity != capacity_) {
+    throw std::runtime_error(
+        "checkpoint " + path + " is for " + std::to_string(c->n_nodes) +
+        " nodes and capacity " + std::to_string(c->capacity) + ", not " +
+        std::to_string(nodes_.size()) + " and " + std::to_string(capacity_));
+  }
+  if (c->node_order != node_order_hash(nodes_)) {
+    throw std::runtime_error("checkpoint " + path +
+                             " numbers the customers differently (another "
+                             "curve, or none)");
+  }
+  for (const auto *routes : {&c->current, &c->best}) {
+    std::vector<int> seen(nodes_.size(), 0);
+    for (const auto &v : *routes) {
+      for (size_t i = 1; i + 1 < v.nodes_.size(); ++i) {
+        seen[v.nodes_[i]]++;
+      }
+    }
+    if (std::count(seen.begin() + 1, seen.end(), 1) + 1 !=
+        static_cast<long>(seen.size())) {
+      throw std::runtime_error("checkpoint " + path +
+                               " does not route every customer once");
+    }
+  }
+  vehicles_ = c->current;
+  resume_ = std::move(c);
+}
+
+void sa_sol::anneal() {
+  stats_ = search_stats();
+  anneal_setup setup;
+  setup.stag_limit = stag_limit_;
+  setup.init_temp = init_temp_;
+  setup.n_reheats = n_reheats_;
+  setup.limits = limits_;
+  setup.shared_best = shared_best_;
+  setup.restart_gap = restart_gap_;
+  setup.trace_path = trace_path_;
+  setup.trace_every = trace_every_;
+  setup.checkpoint_path = checkpoint_path_;
+  setup.checkpoint_every = checkpoint_every_;
+  setup.node_order = node_order_hash(nodes_);
+  setup.resume = resume_.get();
+  const std::vector<int> *focus = focus_.empty() ? nullptr : &focus_;
+
+  // one loop per backend and move set, see annealer
+  auto run = [&](const auto move, const auto &dist) {
+    using dist_t = std::decay_t<decltype(dist)>;
+    const basic_move_ctx<dist_t> ctx{nodes_,   dist,    nbrs_,
+                                     capacity_, &stats_, focus};
+    const annealer<decltype(move), metropolis, geometric_cooling, dist_t> sa(
+        move, metropolis(), geometric_cooling{cooling_rate_});
+    const anneal_result r = sa.run(setup, ctx, vehicles_, rng_);
+    iterations_ = r.iterations;
+    stopped_ = r.stopped;
+  };
+  auto with_backend = [&](const auto move) {
+    switch (dist_mtx_.kind()) {
+    case dist_kind::flat:
+      return run(move, dist_view<dist_kind::flat>(dist_mtx_));
+    case dist_kind::compact:
+      return run(move, dist_view<dist_kind::compact>(dist_mtx_));
+    default:
+      return run(move, dist_view<dist_kind::implicit>(dist_mtx_));
+    }
+  };
+  bool relocate_only = true;
+  for (int k = 1; k < n_move_kinds; ++k) {
+    relocate_only &= mix_.weight[k] <= 0;
+  }
+  if (relocate_only) {
+    with_backend(single_move<mv_relocate>());
+  } else {
+    with_backend(mixed_moves{mix_});
+  }
+  resume_.reset();
 }
@@ -1,31 +1,119 @@
 #ifndef SA_HPP
 #define SA_HPP
 
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "anneal.hpp"
+#include "checkpoint.hpp"
+#include "moves.hpp"
+#include "neighbors.hpp"
+#include "rng.hpp"
+#include "trace.hpp"
 #include "utils.hpp"
 
+// Settings of one annealing run, in constructor order.
+struct sa_params {
+  int stag_limit = 500000;
+  double init_temp = 5000;
+  double cooling_rate = 0.9999;
+  int n_reheats = 20;
+  int n_nbrs = 20;
+  uint64_t seed = 1;
+  move_mix moves;
+  sa_limits limits;
+};
+
 class sa_sol : public sol {
 public:
-  sa_sol(const std::vector<nd> &nodes, const std::vector<veh> &vehicles,
-         const std::vector<std::vector<double>> &distanceMatrix,
+  sa_sol(const node_table &nodes, const std::vector<veh> &vehicles,
+         const dist_mtx &distanceMatrix,
          const int stag_limit = 500000, const double init_temp = 5000,
-         const double cooling_rate = 0.9999, const int n_reheats = 20);
+         const double cooling_rate = 0.9999, const int n_reheats = 20,
+         const int n_nbrs = 20, const uint64_t seed = 1);
 
   explicit sa_sol(const prob &p, const int stag_limit = 500000,
                   const double init_temp = 5000,
-                  const double cooling_rate = 0.9999, const int n_reheats = 20);
+                  const double cooling_rate = 0.9999, const int n_reheats = 20,
+                  const int n_nbrs = 20, const uint64_t seed = 1);
 
   explicit sa_sol(const sol &s, int stag_limit = 500000,
                   double init_temp = 5000, double cooling_rate = 0.9999,
-                  const int n_reheats = 20);
+                  const int n_reheats = 20, const int n_nbrs = 20,
+                  const uint64_t seed = 1);
+
+  sa_sol(const sol &s, const sa_params &params);
 
   void solve() override;
 
+  // Runs the search and leaves the best solution found in vehicles_,
+  // without printing anything.
+  void anneal();
+
+  // Publishes every new best to *best (shared by concurrent searches, see
+  // incumbent) and, at every limit check and reheat, carries on from its
+  // routes when this walk's best since its last restart is more than
+  // restart_gap (relative) above the shared best cost.
+  void share_best(incumbent *best, double restart_gap);
+
+  // Moves proposed by the last anneal().
+  long long iterations() const { return iterations_; }
+
+  // Move counters of the last anneal(); all zero unless built with
+  // CVRP_TRACE.
+  const search_stats &stats() const { return stats_; }
+
+  // Records (time, iteration, temperature, cost, best) every `every`
+  // iterations and writes it to path as CSV at the end of anneal(). Needs
+  // CVRP_TRACE.
+  void trace_to(const std::string &path, int every = 1000);
+
+  // Operators proposed by the search, relocate only by default.
+  void set_moves(const move_mix &mix) { mix_ = mix; }
+
+  // Budget, cancellation and progress reporting of anneal(). When a limit
+  // stops the run, vehicles_ holds the best solution found so far.
+  void set_limits(const sa_limits &limits) { limits_ = limits; }
+
+  // Restricts the customers moves start from (their partners are still
+  // any candidate neighbour); empty for all customers.
+  void set_focus(std::vector<int> customers) { focus_ = std::move(customers); }
+
+  // Whether the last anneal() was stopped by a budget or the token.
+  bool stopped() const { return stopped_; }
+
+  // Writes the search state to path (see checkpoint.hpp) at the first
+  // limit check every `every` iterations, and when a limit stops the run.
+  void checkpoint_to(const std::string &path, long long every = 1000000);
+
+  // The next anneal() carries on from the checkpoint at path, written by a
+  // search of the same problem, and vehicles_ holds its current routes
+  // until then. Throws std::runtime_error when the file cannot be read or
+  // does not fit the problem: other nodes, capacity or numbering.
+  void resume_from(const std::string &path);
+
 private:
   const int stag_limit_;
   const double init_temp_;
   const double cooling_rate_;
   const int n_reheats_;
-  inline static bool allow_move(const double delta, const double temp);
+  // relocation targets of every customer, all nodes when empty
+  nbr_list nbrs_;
+  rng rng_;
+  move_mix mix_;
+  sa_limits limits_;
+  std::vector<int> focus_;
+  bool stopped_ = false;
+  incumbent *shared_best_ = nullptr;
+  double restart_gap_ = 0;
+  long long iterations_ = 0;
+  search_stats stats_;
+  std::string trace_path_;
+  int trace_every_ = 1000;
+  std::string checkpoint_path_;
+  long long checkpoint_every_ = 0;
+  std::shared_ptr<const sa_checkpoint> resume_;
 };
 
 #endif // SA_HPP
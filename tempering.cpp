@@ -0,0 +1,145 @@
+#include "tempering.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include <utility>
+
+#include "moves.hpp"
+#include "pool.hpp"
+#include "rng.hpp"
+
+pt_sol::pt_sol(const sol &start, const int n_replicas, const double t_min,
+               const double t_max, const int n_sweeps, const int sweep_len,
+               const int n_nbrs, const uint64_t seed)
+    : sol(start), n_replicas_(std::max(n_replicas, 1)), t_min_(t_min),
+      t_max_(t_max), n_sweeps_(n_sweeps), sweep_len_(sweep_len), seed_(seed),
+      nbrs_(nodes_, dist_mtx_, n_nbrs) {
+  if (!check_sol_val()) {
+    std::cout << "The input solution is invalid. Exiting." << '\n';
+    exit(0);
+  }
+}
+
+pt_sol::pt_sol(const prob &p, const int n_replicas, const double t_min,
+               const double t_max, const int n_sweeps, const int sweep_len,
+               const int n_nbrs, const uint64_t seed)
+    : sol(p), n_replicas_(std::max(n_replicas, 1)), t_min_(t_min),
+      t_max_(t_max), n_sweeps_(n_sweeps), sweep_len_(sweep_len), seed_(seed),
+      nbrs_(nodes_, dist_mtx_, n_nbrs) {
+  create_init_sol();
+}
+
+template <typename Dist>
+void pt_sol::sweep(replica &rep, const Dist &dist, const uint64_t seed,
+                   const double temp) const {
+  const basic_move_ctx<Dist> ctx{nodes_, dist, nbrs_, capacity_};
+  rng g(seed);
+  const metropolis rule;
+  auto accept = [&](const double delta) { return rule(delta, temp, g); };
+  for (int it = 0; it < sweep_len_; ++it) {
+    double delta = 0;
+    if (apply_move(mix_.pick(g), ctx, rep.rt, g, accept, delta)) {
+      rep.cost += delta;
+      if (rep.cost < rep.best_cost) {
+        rep.rt.commit();
+        rep.best_cost = rep.cost;
+      }
+    }
+  }
+}
+
+void pt_sol::sweep(replica &rep, const uint64_t seed, const double temp) const {
+  switch (dist_mtx_.kind()) {
+  case dist_kind::flat:
+    return sweep(rep, dist_view<dist_kind::flat>(dist_mtx_), seed, temp);
+  case dist_kind::compact:
+    return sweep(rep, dist_view<dist_kind::compact>(dist_mtx_), seed, temp);
+  default:
+    return sweep(rep, dist_view<dist_kind::implicit>(dist_mtx_), seed, temp);
+  }
+}
+
+void pt_sol::temper() {
+  const double cost = std::accumulate(
+      std::begin(vehicles_), std::end(vehicles_), 0.0,
+      [](const double sum, const veh &v) { return sum + v.cost_; });
+  std::vector<double> temps(n_replicas_, t_min_);
+  for (int i = 1; i < n_replicas_; ++i) {
+    temps[i] = t_min_ * std::pow(t_max_ / t_min_,
+                                 static_cast<double>(i) / (n_replicas_ - 1));
+  }
+  // slot i of the ladder runs at temps[i]; states move between slots
+  std::vector<replica> ladder(n_replicas_);
+  for (auto &rep : ladder) {
+    rep.rt = routes(vehicles_, nodes_);
+    rep.cost = cost;
+    rep.best_cost = cost;
+  }
+  routes best = ladder[0].rt;
+  double best_cost = cost;
+  rng g(seed_);
+  const int n_threads = std::min<int>(
+      n_replicas_, std::max(1u, std::thread::hardware_concurrency()));
+  work_pool pool(n_threads);
+  const auto start = std::chrono::steady_clock::now();
+  iterations_ = 0;
+
+  for (int s = 0; limits_.anytime() || s < n_sweeps_; ++s) {
+    if (s > 0) {
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      if (limits_.progress) {
+        limits_.progress({elapsed.count(), iterations_, temps[0], best_cost});
+      }
+      if ((limits_.seconds > 0 && elapsed.count() >= limits_.seconds) ||
+          (limits_.iterations > 0 && iterations_ >= limits_.iterations) ||
+          (limits_.cancel != nullptr &&
+           limits_.cancel->load(std::memory_order_relaxed))) {
+        break;
+      }
+    }
+    for (int i = 0; i < n_replicas_; ++i) {
+      const uint64_t seed = g.next();
+      pool.submit([this, &ladder, &temps, i, seed] {
+        sweep(ladder[i], seed, temps[i]);
+      });
+    }
+    pool.wait();
+    iterations_ += static_cast<long long>(n_replicas_) * sweep_len_;
+
+    // keep the best state reached by any replica, then restart tracking
+    for (auto &rep : ladder) {
+      if (rep.best_cost < best_cost) {
+        best = rep.rt;
+        best.rollback();
+        best_cost = rep.best_cost;
+      }
+      rep.rt.commit();
+      rep.best_cost = rep.cost;
+    }
+
+    // exchange even or odd neighbour pairs, alternating
+    for (int i = s % 2; i + 1 < n_replicas_; i += 2) {
+      const double x = (1 / temps[i] - 1 / temps[i + 1]) *
+                       (ladder[i].cost - ladder[i + 1].cost);
+      if (x >= 0 || g.uniform() < std::exp(x)) {
+        std::swap(ladder[i], ladder[i + 1]);
+      }
+    }
+  }
+
+  best.to_vehicles(vehicles_);
+}
+
+void pt_sol::solve() {
+  temper();
+  const double cost = std::accumulate(
+      std::begin(vehicles_), std::end(vehicles_), 0.0,
+      [](const double sum, const veh &v) { return sum + v.cost_; });
+  std::cout << "Cost: " << cost << '\n';
+  std::cout << "Solution valid: " << check_sol_val() << '\n';
+}
@@ -0,0 +1,75 @@
+#ifndef TEMPERING_HPP
+#define TEMPERING_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "anneal.hpp"
+#include "moves.hpp"
+#include "neighbors.hpp"
+#include "routes.hpp"
+#include "utils.hpp"
+
+// Parallel tempering (replica exchange). A ladder of n_replicas solutions is
+// annealed at fixed temperatures, geometrically spaced from t_min to t_max,
+// with the metropolis rule of anneal.hpp. Every sweep runs each replica for
+// sweep_len move proposals as a task on a work_pool of up to one thread per
+// replica, started once per run. After every sweep, neighbouring replicas
+// exchange their states with the Metropolis criterion; the exchange swaps
+// ownership of the states, nothing is copied.
+class pt_sol : public sol {
+public:
+  pt_sol(const sol &start, int n_replicas = 8, double t_min = 0.5,
+         double t_max = 50, int n_sweeps = 1000, int sweep_len = 10000,
+         int n_nbrs = 20, uint64_t seed = 1);
+
+  // Starts from sol::create_init_sol.
+  explicit pt_sol(const prob &p, int n_replicas = 8, double t_min = 0.5,
+                  double t_max = 50, int n_sweeps = 1000,
+                  int sweep_len = 10000, int n_nbrs = 20, uint64_t seed = 1);
+
+  void solve() override;
+
+  // Runs the ladder and leaves the best solution found in vehicles_,
+  // without printing anything.
+  void temper();
+
+  // Operators proposed in a sweep, relocate only by default.
+  void set_moves(const move_mix &mix) { mix_ = mix; }
+
+  // With a time or iteration budget the ladder keeps sweeping until it is
+  // spent instead of stopping after n_sweeps. Limits are checked between
+  // sweeps, and iterations count the proposals of all replicas.
+  void set_limits(const sa_limits &limits) { limits_ = limits; }
+
+  // Moves proposed by the last temper(), over all replicas.
+  long long iterations() const { return iterations_; }
+
+private:
+  // A solution travelling along the ladder. Its journal holds the moves
+  // since the best state it reached during the current sweep.
+  struct replica {
+    routes rt;
+    double cost = 0;
+    double best_cost = 0;
+  };
+
+  // Runs one sweep through the dist_view of the distance backend, as
+  // sa_sol::anneal does.
+  void sweep(replica &rep, uint64_t seed, double temp) const;
+  template <typename Dist>
+  void sweep(replica &rep, const Dist &dist, uint64_t seed, double temp) const;
+
+  const int n_replicas_;
+  const double t_min_;
+  const double t_max_;
+  const int n_sweeps_;
+  const int sweep_len_;
+  const uint64_t seed_;
+  nbr_list nbrs_;
+  move_mix mix_;
+  sa_limits limits_;
+  long long iterations_ = 0;
+};
+
+#endif // TEMPERING_HPP
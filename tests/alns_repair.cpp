@@ -0,0 +1,67 @@
+// ALNS repair on a case small enough to know the answer.
+//
+// Depot at the origin, customer 1 far to the left, customers 2 and 3 side
+// by side far to the right; capacity 10. Route 0 holds 1 (demand 6) and
+// route 1 holds 2 and 3 (demands 5 and 1). Taking 2 and 3 out leaves route
+// 1 empty, and 2 only fits there. Once 2 has opened it, 3 belongs next to
+// 2 rather than on route 0, across the depot from it.
+//
+// Exits with 1 when some repair kind gets it wrong.
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "alns.hpp"
+#include "greedy.hpp"
+
+namespace {
+
+bool check(const repair_kind kind) {
+  const std::vector<double> xs = {0, -100, 100, 100};
+  const std::vector<double> ys = {0, 0, 0, 1};
+  const std::vector<int> demands = {0, 6, 5, 1};
+  std::vector<nd> nodes;
+  for (size_t i = 0; i < xs.size(); ++i) {
+    nodes.emplace_back(xs[i], ys[i], i, demands[i]);
+  }
+  std::vector<veh> vehicles;
+  for (int r = 0; r < 2; ++r) {
+    vehicles.emplace_back(r, 10, 10);
+  }
+  nn_sol start(node_table(std::move(nodes)), vehicles,
+               dist_mtx(xs, ys, dist_kind::flat));
+  start.set_routes({{1}, {2, 3}});
+
+  alns_sol alns(start);
+  if (!alns.reinsert({2, 3}, kind)) {
+    std::cout << "repair " << kind << ": no insertion found" << '\n';
+    return false;
+  }
+  const std::vector<std::vector<int>> routes = alns.get_routes();
+  const bool together = routes.size() == 2 && routes[0].size() == 1 &&
+                        routes[1].size() == 2;
+  double cost = 0;
+  for (const auto &v : alns.vehicles_) {
+    cost += v.cost_;
+  }
+  const double expected = 200 + 100 + 1 + std::hypot(100, 1);
+  if (!together || std::abs(cost - expected) > 1e-6 ||
+      !alns.check_sol_val()) {
+    std::cout << "repair " << kind << ": cost " << cost << ", expected "
+              << expected << '\n';
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+int main() {
+  int failed = 0;
+  for (const repair_kind kind : {rp_greedy, rp_regret2, rp_regret3}) {
+    failed += !check(kind);
+  }
+  std::cout << (failed ? "FAILED" : "ok") << '\n';
+  return failed > 0;
+}
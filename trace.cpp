@@ -0,0 +1,32 @@
+#include "trace.hpp"
+
+#include <cstdio>
+#include <sstream>
+
+std::string search_stats::summary() const {
+  std::ostringstream os;
+  os << "Proposed: " << proposed << '\n';
+  os << "Skipped: " << skipped() << '\n';
+  os << "Rejected (capacity): " << capacity << '\n';
+  os << "Rejected (metropolis): " << metropolis << '\n';
+  os << "Accepted: " << accepted << '\n';
+  os << "New best: " << improved << '\n';
+  for (size_t r = 1; r < reheat_best.size(); ++r) {
+    os << "Reheat " << r - 1 << " best: " << reheat_best[r]
+       << (reheat_best[r] < reheat_best[r - 1] ? " (improved)" : "") << '\n';
+  }
+  return os.str();
+}
+
+bool search_trace::write_csv(const std::string &path) const {
+  FILE *out = std::fopen(path.c_str(), "w");
+  if (out == nullptr) {
+    return false;
+  }
+  std::fprintf(out, "seconds,iteration,temperature,cost,best\n");
+  for (const auto &s : samples_) {
+    std::fprintf(out, "%.6f,%lld,%.6g,%.6f,%.6f\n", s.seconds, s.iteration,
+                 s.temp, s.cost, s.best);
+  }
+  return std::fclose(out) == 0;
+}
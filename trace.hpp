@@ -0,0 +1,94 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <chrono>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Search instrumentation, compiled in with -DCVRP_TRACE (make TRACE=1).
+// Without it CVRP_COUNT and CVRP_TRACE_ON expand to nothing and the search
+// loops carry no extra work; the types below still exist so that callers
+// need no #ifdefs, and simply stay empty.
+
+#ifdef CVRP_TRACE
+#define CVRP_COUNT(stats, field)                                               \
+  do {                                                                         \
+    if (stats) {                                                               \
+      ++(stats)->field;                                                        \
+    }                                                                          \
+  } while (0)
+#define CVRP_TRACE_ON(...) __VA_ARGS__
+#else
+#define CVRP_COUNT(stats, field)                                               \
+  do {                                                                         \
+  } while (0)
+#define CVRP_TRACE_ON(...)
+#endif
+
+// Fate of the proposed moves. skipped (no-op or unroutable proposals) is
+// what the other counters leave of proposed.
+struct search_stats {
+  long long proposed = 0;
+  long long capacity = 0;   // rejected for capacity
+  long long metropolis = 0; // rejected by the acceptance test
+  long long accepted = 0;
+  long long improved = 0; // accepted and a new best
+
+  // best cost at the end of every reheat, the initial cost first
+  std::vector<double> reheat_best;
+
+  long long skipped() const {
+    return proposed - capacity - metropolis - accepted;
+  }
+
+  // One line per counter, for humans.
+  std::string summary() const;
+};
+
+// One point of a convergence trace.
+struct trace_sample {
+  double seconds;
+  long long iteration;
+  double temp;
+  double cost;
+  double best;
+};
+
+// Convergence trace sampled every `every` iterations, kept in memory and
+// written out as CSV once the search is over.
+class search_trace {
+public:
+  search_trace() = default;
+
+  // Samples every `every` iterations, never when every is 0.
+  explicit search_trace(const int every)
+      : every_(every), next_(every > 0 ? every : never),
+        start_(std::chrono::steady_clock::now()) {}
+
+  // A compare rather than a modulo, this runs every iteration.
+  bool due(const long long iteration) const { return iteration >= next_; }
+
+  void sample(const long long iteration, const double temp, const double cost,
+              const double best) {
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start_;
+    samples_.push_back({elapsed.count(), iteration, temp, cost, best});
+    next_ = iteration + every_;
+  }
+
+  const std::vector<trace_sample> &samples() const { return samples_; }
+
+  // Writes "seconds,iteration,temperature,cost,best" rows; false when the
+  // file cannot be written.
+  bool write_csv(const std::string &path) const;
+
+private:
+  static constexpr long long never = std::numeric_limits<long long>::max();
+  int every_ = 0;
+  long long next_ = never;
+  std::chrono::steady_clock::time_point start_;
+  std::vector<trace_sample> samples_;
+};
+
+#endif // TRACE_HPP
@@ -0,0 +1,371 @@
+#include "tsplib.hpp"
+
+#include <charconv>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <string_view>
+
+#include "mapped_file.hpp"
+
+namespace {
+
+std::string_view trim(std::string_view s) {
+  const auto first = s.find_first_not_of(" \t\r");
+  if (first == std::string_view::npos) {
+    return {};
+  }
+  const auto last = s.find_last_not_of(" \t\r");
+  return s.substr(first, last - first + 1);
+}
+
+// Walks the mapped text, keeping track of the line for error messages.
+class cursor {
+public:
+  cursor(const char *begin, const char *end, const std::string &path)
+      : p_(begin), end_(end), path_(path) {}
+
+  // Skips blanks and line breaks; false at the end of the file.
+  bool skip_space() {
+    for (; p_ != end_; ++p_) {
+      if (*p_ == '\n') {
+        ++line_;
+      } else if (*p_ != ' ' && *p_ != '\t' && *p_ != '\r') {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // The rest of the current line, without the line break.
+  std::string_view rest_of_line() {
+    const char *start = p_;
+    while (p_ != end_ && *p_ != '\n') {
+      ++p_;
+    }
+    return trim(std::string_view(start, p_ - start));
+  }
+
+  // The next whitespace-delimited token, empty at the end of the file.
+  std::string_view token() {
+    if (!skip_space()) {
+      return {};
+    }
+    const char *start = p_;
+    while (p_ != end_ && *p_ != ' ' && *p_ != '\t' && *p_ != '\r' &&
+           *p_ != '\n') {
+      ++p_;
+    }
+    return std::string_view(start, p_ - start);
+  }
+
+  // The next token as a number; what names the value in error messages.
+  template <typename T> T number(const char *what) {
+    const std::string_view tok = token();
+    return parse<T>(tok, what);
+  }
+
+  template <typename T> T parse(const std::string_view tok, const char *what) {
+    T value{};
+    const auto [end, ec] =
+        std::from_chars(tok.data(), tok.data() + tok.size(), value);
+    if (tok.empty() || ec != std::errc() || end != tok.data() + tok.size()) {
+      fail("expected " + std::string(what) + ", got '" + std::string(tok) +
+           "'");
+    }
+    return value;
+  }
+
+  [[noreturn]] void fail(const std::string &msg) const {
+    throw std::runtime_error(path_ + ":" + std::to_string(line_) + ": " +
+                             msg);
+  }
+
+private:
+  const char *p_;
+  const char *end_;
+  const std::string &path_;
+  int line_ = 1;
+};
+
+enum class weight_format {
+  none,
+  full_matrix,
+  lower_row,
+  lower_diag_row,
+  upper_row,
+  upper_diag_row
+};
+
+size_t tri_idx(const size_t i, const size_t j) {
+  return i >= j ? i * (i + 1) / 2 + j : j * (j + 1) / 2 + i;
+}
+
+// Reads "id value..." lines for every node into fill(index).
+template <typename F>
+void read_node_section(cursor &cur, const int dimension, const char *section,
+                       F fill) {
+  if (dimension <= 0) {
+    cur.fail(std::string(section) + " before DIMENSION");
+  }
+  for (int i = 0; i < dimension; ++i) {
+    const int id = cur.number<int>("node id");
+    if (id < 1 || id > dimension) {
+      cur.fail("node id " + std::to_string(id) + " out of range 1.." +
+               std::to_string(dimension));
+    }
+    fill(id - 1);
+  }
+}
+
+void read_weights(cursor &cur, tsplib &in, const weight_format format) {
+  const size_t n = in.dimension;
+  if (n == 0) {
+    cur.fail("EDGE_WEIGHT_SECTION before DIMENSION");
+  }
+  in.weights.assign(n * (n + 1) / 2, 0);
+  auto at = [&](const size_t i, const size_t j) -> double & {
+    return in.weights[tri_idx(i, j)];
+  };
+  switch (format) {
+  case weight_format::full_matrix:
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t j = 0; j < n; ++j) {
+        const double w = cur.number<double>("edge weight");
+        if (j <= i) {
+          at(i, j) = w;
+        }
+      }
+    }
+    break;
+  case weight_format::lower_row:
+  case weight_format::lower_diag_row: {
+    const size_t diag = format == weight_format::lower_diag_row;
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t j = 0; j < i + diag; ++j) {
+        at(i, j) = cur.number<double>("edge weight");
+      }
+    }
+    break;
+  }
+  case weight_format::upper_row:
+  case weight_format::upper_diag_row: {
+    const size_t diag = format == weight_format::upper_diag_row;
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t j = i + 1 - diag; j < n; ++j) {
+        at(i, j) = cur.number<double>("edge weight");
+      }
+    }
+    break;
+  }
+  default:
+    cur.fail("EDGE_WEIGHT_SECTION without a supported EDGE_WEIGHT_FORMAT");
+  }
+}
+
+// Moves node depot to the front, the others keeping their order.
+void depot_first(tsplib &in, const int depot) {
+  if (depot == 0) {
+    return;
+  }
+  const int n = in.dimension;
+  std::vector<int> order(n);
+  order[0] = depot;
+  for (int i = 0, k = 1; i < n; ++i) {
+    if (i != depot) {
+      order[k++] = i;
+    }
+  }
+  auto permute = [&](auto &v) {
+    if (v.empty()) {
+      return;
+    }
+    auto old = v;
+    for (int i = 0; i < n; ++i) {
+      v[i] = old[order[i]];
+    }
+  };
+  permute(in.xs);
+  permute(in.ys);
+  permute(in.demands);
+  permute(in.ids);
+  if (!in.weights.empty()) {
+    std::vector<double> old = in.weights;
+    for (int i = 0; i < n; ++i) {
+      for (int j = 0; j <= i; ++j) {
+        in.weights[tri_idx(i, j)] = old[tri_idx(order[i], order[j])];
+      }
+    }
+  }
+}
+
+} // namespace
+
+tsplib read_tsplib(const std::string &path) {
+  const mapped_file file(path);
+  if (!file.error().empty()) {
+    throw std::runtime_error("cannot read " + path + ": " + file.error());
+  }
+  cursor cur(file.begin(), file.end(), path);
+  tsplib in;
+  bool explicit_weights = false;
+  weight_format format = weight_format::none;
+  bool has_demands = false;
+  int depot = -1;
+
+  while (cur.skip_space()) {
+    const std::string_view line = cur.rest_of_line();
+    const auto colon = line.find(':');
+    const std::string_view key = trim(line.substr(0, colon));
+    const std::string_view value =
+        colon == std::string_view::npos ? "" : trim(line.substr(colon + 1));
+
+    if (key == "EOF") {
+      break;
+    } else if (key == "NAME") {
+      in.name = value;
+    } else if (key == "DIMENSION") {
+      in.dimension = cur.parse<int>(value, "DIMENSION");
+      if (in.dimension < 1) {
+        cur.fail("DIMENSION must be positive");
+      }
+    } else if (key == "CAPACITY") {
+      in.capacity = cur.parse<int>(value, "CAPACITY");
+    } else if (key == "EDGE_WEIGHT_TYPE") {
+      if (value == "EXPLICIT") {
+        explicit_weights = true;
+      } else if (value != "EUC_2D") {
+        cur.fail("unsupported EDGE_WEIGHT_TYPE " + std::string(value) +
+                 " (expected EUC_2D or EXPLICIT)");
+      }
+    } else if (key == "EDGE_WEIGHT_FORMAT") {
+      if (value == "FULL_MATRIX") {
+        format = weight_format::full_matrix;
+      } else if (value == "LOWER_ROW") {
+        format = weight_format::lower_row;
+      } else if (value == "LOWER_DIAG_ROW") {
+        format = weight_format::lower_diag_row;
+      } else if (value == "UPPER_ROW") {
+        format = weight_format::upper_row;
+      } else if (value == "UPPER_DIAG_ROW") {
+        format = weight_format::upper_diag_row;
+      } else {
+        cur.fail("unsupported EDGE_WEIGHT_FORMAT " + std::string(value));
+      }
+    } else if (key == "NODE_COORD_SECTION" ||
+               key == "DISPLAY_DATA_SECTION") {
+      in.xs.resize(in.dimension);
+      in.ys.resize(in.dimension);
+      read_node_section(cur, in.dimension, "NODE_COORD_SECTION",
+                        [&](const int i) {
+                          in.xs[i] = cur.number<double>("x coordinate");
+                          in.ys[i] = cur.number<double>("y coordinate");
+                        });
+    } else if (key == "DEMAND_SECTION") {
+      in.demands.resize(in.dimension);
+      read_node_section(cur, in.dimension, "DEMAND_SECTION",
+                        [&](const int i) {
+                          in.demands[i] = cur.number<int>("demand");
+                        });
+      has_demands = true;
+    } else if (key == "EDGE_WEIGHT_SECTION") {
+      read_weights(cur, in, format);
+    } else if (key == "DEPOT_SECTION") {
+      for (int id = cur.number<int>("depot id"); id != -1;
+           id = cur.number<int>("depot id")) {
+        if (depot >= 0) {
+          cur.fail("more than one depot is not supported");
+        }
+        if (id < 1 || id > in.dimension) {
+          cur.fail("depot id " + std::to_string(id) + " out of range");
+        }
+        depot = id - 1;
+      }
+    } else if (colon == std::string_view::npos) {
+      cur.fail("unknown section " + std::string(key));
+    }
+    // other "KEY : value" entries (COMMENT, TYPE, ...) are ignored
+  }
+
+  if (in.dimension == 0) {
+    cur.fail("missing DIMENSION");
+  }
+  if (in.capacity <= 0) {
+    cur.fail("missing or non-positive CAPACITY");
+  }
+  if (!has_demands) {
+    cur.fail("missing DEMAND_SECTION");
+  }
+  if (explicit_weights && in.weights.empty()) {
+    cur.fail("EDGE_WEIGHT_TYPE EXPLICIT without EDGE_WEIGHT_SECTION");
+  }
+  if (!explicit_weights && in.xs.empty()) {
+    cur.fail("missing NODE_COORD_SECTION");
+  }
+  if (!explicit_weights) {
+    in.weights.clear();
+  }
+  in.ids.resize(in.dimension);
+  for (int i = 0; i < in.dimension; ++i) {
+    in.ids[i] = i + 1;
+  }
+  depot_first(in, depot < 0 ? 0 : depot);
+  return in;
+}
+
+cvrplib_sol read_cvrplib_sol(const std::string &path) {
+  const mapped_file file(path);
+  if (!file.error().empty()) {
+    throw std::runtime_error("cannot read " + path + ": " + file.error());
+  }
+  cursor cur(file.begin(), file.end(), path);
+  cvrplib_sol out;
+  while (cur.skip_space()) {
+    const std::string_view line = cur.rest_of_line();
+    if (line.substr(0, 5) == "Route") {
+      const auto colon = line.find(':');
+      if (colon == std::string_view::npos) {
+        cur.fail("expected ':' after the route number");
+      }
+      std::vector<int> route;
+      std::string_view rest = line.substr(colon + 1);
+      for (rest = trim(rest); !rest.empty();) {
+        const auto space = rest.find_first_of(" \t");
+        const std::string_view tok = rest.substr(0, space);
+        const int id = cur.parse<int>(tok, "customer id");
+        if (id < 1) {
+          cur.fail("customer id " + std::to_string(id) + " out of range");
+        }
+        route.push_back(id);
+        rest = space == std::string_view::npos ? std::string_view()
+                                               : trim(rest.substr(space));
+      }
+      out.routes.push_back(std::move(route));
+    } else if (line.substr(0, 4) == "Cost") {
+      out.cost = cur.parse<double>(trim(line.substr(4)), "cost");
+    }
+  }
+  if (out.routes.empty()) {
+    cur.fail("no routes");
+  }
+  return out;
+}
+
+bool write_cvrplib_sol(const std::string &path,
+                       const std::vector<std::vector<int>> &routes,
+                       const double cost) {
+  std::ofstream out(path);
+  int k = 0;
+  for (const auto &route : routes) {
+    if (route.empty()) {
+      continue;
+    }
+    out << "Route #" << ++k << ':';
+    for (const int id : route) {
+      out << ' ' << id;
+    }
+    out << '\n';
+  }
+  out << "Cost " << std::setprecision(12) << cost << '\n';
+  return static_cast<bool>(out);
+}
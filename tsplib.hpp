@@ -0,0 +1,56 @@
+#ifndef TSPLIB_HPP
+#define TSPLIB_HPP
+
+#include <string>
+#include <vector>
+
+// Contents of a TSPLIB / CVRPLIB instance file.
+//
+// Supported: EDGE_WEIGHT_TYPE EUC_2D (from NODE_COORD_SECTION) and EXPLICIT
+// with EDGE_WEIGHT_FORMAT FULL_MATRIX, LOWER_ROW, LOWER_DIAG_ROW, UPPER_ROW
+// or UPPER_DIAG_ROW, plus DEMAND_SECTION, DEPOT_SECTION (a single depot) and
+// DISPLAY_DATA_SECTION.
+//
+// Node 0 is the depot. When DEPOT_SECTION names another node, that node is
+// moved to the front and the others keep their order.
+struct tsplib {
+  std::string name;
+  int dimension = 0;
+  int capacity = 0;
+  // coordinates, empty for EXPLICIT instances without display data
+  std::vector<double> xs, ys;
+  std::vector<int> demands;
+  // EXPLICIT instances only: lower triangle of the (symmetric) weight
+  // matrix, diagonal included, row by row. FULL_MATRIX keeps the entries
+  // below the diagonal.
+  std::vector<double> weights;
+  // 1-based id of every node in the file
+  std::vector<int> ids;
+};
+
+// Maps the file and parses it in place. Throws std::runtime_error naming
+// the file (and line) when it cannot be read or is malformed.
+tsplib read_tsplib(const std::string &path);
+
+// Contents of a CVRPLIB solution file:
+//   Route #1: 5 49 10 39
+//   Route #2: 47 4 42
+//   Cost 521
+// Customers are numbered from 1 and the depot is left out, so customer k
+// is node k of an instance whose depot is its first node.
+struct cvrplib_sol {
+  std::vector<std::vector<int>> routes;
+  double cost = -1; // -1 when there is no Cost line
+};
+
+// Maps the file and parses it, with the same error handling as
+// read_tsplib. Lines other than routes and the cost are ignored.
+cvrplib_sol read_cvrplib_sol(const std::string &path);
+
+// Writes routes in the format above, empty ones left out. Returns false
+// when the file cannot be written.
+bool write_cvrplib_sol(const std::string &path,
+                       const std::vector<std::vector<int>> &routes,
+                       double cost);
+
+#endif // TSPLIB_HPP
@@ -1,14 +1,18 @@
 #include "utils.hpp"
 
 #include <algorithm>
-#include <fstream>
 #include <iostream>
 #include <limits>
-#include <random>
-#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <tuple>
 #include <utility>
 
+#include "grid.hpp"
+#include "kernels.hpp"
+#include "rng.hpp"
+#include "tsplib.hpp"
+
 std::ostream &operator<<(std::ostream &os, const nd &node) {
   os << "Node Status" << '\n';
   os << "ID    : " << node.id_ << '\n';
@@ -19,10 +23,10 @@ std::ostream &operator<<(std::ostream &os, const nd &node) {
   return os;
 }
 
-void veh::calc_cost(const std::vector<std::vector<double>> &distanceMatrix) {
+void veh::calc_cost(const dist_mtx &distanceMatrix) {
   cost_ = 0;
   for (size_t i = 0; i < nodes_.size() - 1; i++) {
-    cost_ += distanceMatrix[nodes_[i]][nodes_[i + 1]];
+    cost_ += distanceMatrix(nodes_[i], nodes_[i + 1]);
   }
 }
 
@@ -49,31 +53,73 @@ void print_veh_route(const veh &v) {
   std::cout << '\n' << '\n';
 }
 
-sol::sol(std::vector<nd> nodes, const std::vector<veh> &vehicles,
-         std::vector<std::vector<double>> distanceMatrix)
+sol::sol(node_table nodes, const std::vector<veh> &vehicles,
+         dist_mtx distanceMatrix)
     : nodes_(std::move(nodes)), vehicles_(vehicles),
       dist_mtx_(std::move(distanceMatrix)) {
   depot_ = nodes_[0];
   capacity_ = vehicles[0].load_;
+  init_open_dem();
 }
 
 sol::sol(const prob &p)
     : nodes_(p.nodes_), vehicles_(p.vehicles_), dist_mtx_(p.dist_mtx_),
       capacity_(p.capacity_) {
   depot_ = nodes_[0];
+  init_open_dem();
+}
+
+void sol::init_open_dem() {
+  open_dem_.resize(nodes_.size());
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    open_dem_[i] = i == 0 ? std::numeric_limits<int>::max() : nodes_[i].demand_;
+  }
+}
+
+void sol::mark_routed(const int id) {
+  open_dem_[id] = std::numeric_limits<int>::max();
 }
 
 void sol::create_init_sol() {
+  if (!dist_mtx_.euclidean()) {
+    // explicit weights: no geometry to index, scan the rows instead
+    for (auto &v : vehicles_) {
+      while (true) {
+        const auto [found, closest] = find_closest(v);
+        if (found) {
+          v.load_ -= closest.demand_;
+          v.cost_ += dist_mtx_(v.nodes_.back(), closest.id_);
+          v.nodes_.push_back(closest.id_);
+          mark_routed(closest.id_);
+        } else {
+          v.cost_ += dist_mtx_(v.nodes_.back(), depot_.id_);
+          v.nodes_.push_back(depot_.id_);
+          break;
+        }
+      }
+    }
+    return;
+  }
+  std::vector<int> open;
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    if (!is_routed(i)) {
+      open.push_back(i);
+    }
+  }
+  grid unrouted(dist_mtx_, nodes_, open);
   for (auto &v : vehicles_) {
     while (true) {
-      const auto [found, closest_node] = find_closest(v);
-      if (found && v.load_ - closest_node.demand_ >= 0) { // }.2*capacity){
-        v.load_ -= closest_node.demand_;
-        v.cost_ += dist_mtx_[v.nodes_.back()][closest_node.id_];
-        v.nodes_.push_back(closest_node.id_);
-        nodes_[closest_node.id_].is_routed_ = true;
+      const nd &last = nodes_[v.nodes_.back()];
+      const int id = unrouted.nearest(dist_mtx_.x(last.id_),
+                                      dist_mtx_.y(last.id_), v.load_);
+      if (id >= 0) {
+        v.load_ -= nodes_[id].demand_;
+        v.cost_ += dist_mtx_(last.id_, id);
+        v.nodes_.push_back(id);
+        mark_routed(id);
+        unrouted.erase(id);
       } else {
-        v.cost_ += dist_mtx_[v.nodes_.back()][depot_.id_];
+        v.cost_ += dist_mtx_(last.id_, depot_.id_);
         v.nodes_.push_back(depot_.id_);
         break;
       }
@@ -82,23 +128,65 @@ void sol::create_init_sol() {
 }
 
 std::tuple<bool, nd> sol::find_closest(const veh &v) const {
-  double cost = std::numeric_limits<double>::max();
-  size_t id = 0;
-  bool found = false;
-  for (size_t j = 0; j < dist_mtx_[0].size(); j++) {
-    if (!nodes_[j].is_routed_ && nodes_[j].demand_ <= v.load_ &&
-        dist_mtx_[v.nodes_.back()][j] < cost) {
-      cost = dist_mtx_[v.nodes_.back()][j];
-      id = j;
-      found = true;
-    }
-  }
-  if (found) {
+  const double *row = dist_mtx_.row(v.nodes_.back(), row_buf_);
+  const int id =
+      masked_argmin(row, open_dem_.data(), open_dem_.size(), v.load_);
+  if (id >= 0) {
     return {true, nodes_[id]};
   }
   return {false, nd()};
 }
 
+std::vector<std::vector<int>> sol::get_routes() const {
+  std::vector<std::vector<int>> routes;
+  for (const auto &v : vehicles_) {
+    routes.emplace_back();
+    for (const int id : v.nodes_) {
+      if (id != depot_.id_) {
+        routes.back().push_back(nodes_.orig_id(id));
+      }
+    }
+  }
+  return routes;
+}
+
+void sol::set_routes(const std::vector<std::vector<int>> &routes) {
+  const int n = nodes_.size();
+  // original id -> id
+  std::vector<int> id_of(n);
+  for (int i = 0; i < n; ++i) {
+    id_of[nodes_.orig_id(i)] = i;
+  }
+  init_open_dem();
+  while (vehicles_.size() < routes.size()) {
+    vehicles_.emplace_back(vehicles_.size(), capacity_, capacity_);
+  }
+  for (size_t r = 0; r < vehicles_.size(); ++r) {
+    veh &v = vehicles_[r];
+    v.nodes_.assign(1, depot_.id_);
+    v.load_ = capacity_;
+    if (r < routes.size()) {
+      for (const int orig : routes[r]) {
+        if (orig < 1 || orig >= n) {
+          throw std::runtime_error("customer " + std::to_string(orig) +
+                                   " out of range 1.." +
+                                   std::to_string(n - 1));
+        }
+        const int id = id_of[orig];
+        if (is_routed(id)) {
+          throw std::runtime_error("customer " + std::to_string(orig) +
+                                   " is on two routes");
+        }
+        v.nodes_.push_back(id);
+        v.load_ -= nodes_[id].demand_;
+        mark_routed(id);
+      }
+    }
+    v.nodes_.push_back(depot_.id_);
+    v.calc_cost(dist_mtx_);
+  }
+}
+
 bool sol::check_sol_val() const {
   std::vector<bool> check_nodes(nodes_.size(), false);
   check_nodes[0] = true;
@@ -116,7 +204,8 @@ bool sol::check_sol_val() const {
                      [](const bool b) { return b; });
 }
 
-prob::prob(const std::string &input_path, const int nov) {
+prob::prob(const std::string &input_path, const int nov,
+           const dist_kind kind) {
   /*
   Function to read the input file and initialize the problem.
 
@@ -148,60 +237,23 @@ EOF
 
   Depot is located in node 1.
   Dimension is the number of nodes.
+
+  EXPLICIT edge weights and other depots are handled too, see tsplib.hpp.
   */
 
-  std::ifstream ifile(input_path);
-  std::string line;
-  std::string word;
-  std::vector<std::string> words;
-  std::vector<std::vector<double>> coordinates;
-  std::vector<int> demands;
-  int dimension = 0;
-  int capacity = 0;
-  int depot = 0;
-  while (std::getline(ifile, line)) {
-    std::istringstream iss(line);
-    while (iss >> word) {
-      words.push_back(word);
-    }
-    if (words[0] == "DIMENSION") {
-      dimension = std::stoi(words[2]);
-    } else if (words[0] == "CAPACITY") {
-      capacity = std::stoi(words[2]);
-    } else if (words[0] == "NODE_COORD_SECTION") {
-      for (int i = 0; i < dimension; i++) {
-        std::getline(ifile, line);
-        std::istringstream iss(line);
-        int node_id = 0;
-        iss >> node_id;
-        std::vector<double> coord;
-        while (iss >> word) {
-          coord.push_back(std::stod(word));
-        }
-        coordinates.push_back(coord);
-      }
-    } else if (words[0] == "DEMAND_SECTION") {
-      for (int i = 0; i < dimension; i++) {
-        std::getline(ifile, line);
-        std::istringstream iss(line);
-        int demand_id = 0;
-        iss >> demand_id;
-        while (iss >> word) {
-          demands.push_back(std::stoi(word));
-        }
-      }
-    }
-    words.clear();
-  }
-  ifile.close();
+  const tsplib in = read_tsplib(input_path);
 
   // Create nodes
-  nd depot_node(coordinates[0][0], coordinates[0][1], 0, 0, true);
-  nodes_.push_back(depot_node);
-  for (int i = 1; i < dimension; i++) {
-    nd node(coordinates[i][0], coordinates[i][1], i, demands[i], false);
-    nodes_.push_back(node);
+  const int dimension = in.dimension;
+  const bool has_coords = !in.xs.empty();
+  std::vector<nd> nodes;
+  for (int i = 0; i < dimension; i++) {
+    const double x = has_coords ? in.xs[i] : 0;
+    const double y = has_coords ? in.ys[i] : 0;
+    nodes.push_back(nd(x, y, i, i == 0 ? 0 : in.demands[i]));
   }
+  nodes_ = std::move(nodes);
+  const int capacity = in.capacity;
 
   // Create vehicles
   for (int i = 0; i < nov; i++) {
@@ -211,14 +263,10 @@ EOF
   }
 
   // Create distance matrix
-  for (const auto &n1 : nodes_) {
-    std::vector<double> row;
-    for (const auto &n2 : nodes_) {
-      double distance =
-          std::sqrt(std::pow(n1.x_ - n2.x_, 2) + std::pow(n1.y_ - n2.y_, 2));
-      row.push_back(distance);
-    }
-    dist_mtx_.push_back(row);
+  if (!in.weights.empty()) {
+    dist_mtx_ = dist_mtx(in.weights, dimension, kind);
+  } else {
+    dist_mtx_ = dist_mtx(in.xs, in.ys, kind);
   }
 
   capacity_ = capacity;
@@ -253,59 +301,63 @@ prob::prob(char x) {}
 
 prob::prob(const int noc, const int demand_range, const int nov,
            const int capacity, const int grid_range, std::string distribution,
-           const int n_clusters, const int cluster_range) {
-  std::random_device rd;  // obtain a random number from hardware
-  std::mt19937 eng(rd()); // seed the generator
-  std::uniform_int_distribution<int> ran(-grid_range,
-                                         grid_range); // define the range
-  std::uniform_int_distribution<int> ran_d(0,
-                                           demand_range); // define the range
-  std::uniform_int_distribution<int> ran_c(-cluster_range, cluster_range);
-  nd depot(0, 0, 0, 0, true);
+           const int n_clusters, const int cluster_range,
+           const dist_kind kind, const uint64_t seed) {
+  rng eng(seed); // seed the generator
+  // uniform integer in [lo, hi]
+  auto ran_in = [&eng](const int lo, const int hi) {
+    return lo + static_cast<int>(eng.below(hi - lo + 1));
+  };
+  auto ran = [&]() { return ran_in(-grid_range, grid_range); };
+  auto ran_d = [&]() { return ran_in(0, demand_range); };
+  auto ran_c = [&]() { return ran_in(-cluster_range, cluster_range); };
+  nd depot(0, 0, 0, 0);
   this->capacity_ = capacity;
 
-  nodes_.push_back(depot);
+  std::vector<nd> nodes;
+  nodes.push_back(depot);
 
   if (distribution != "uniform" && distribution != "cluster") {
     distribution = "uniform";
   }
   if (distribution == "uniform") {
     for (int i = 1; i <= noc; ++i) {
-      nodes_.emplace_back(ran(eng), ran(eng), i, ran_d(eng), false);
+      const int x = ran();
+      const int y = ran();
+      nodes.emplace_back(x, y, i, ran_d());
     }
   } else if (distribution == "cluster") {
     int id = 1;
     int n_p_c = noc / n_clusters;
     int remain = noc % n_clusters;
     for (int i = 0; i < n_clusters; i++) {
-      int x = ran(eng);
-      int y = ran(eng);
+      int x = ran();
+      int y = ran();
       for (int j = 0; j < n_p_c; j++) {
-        nodes_.emplace_back(x + ran_c(eng), y + ran_c(eng), id, ran_d(eng),
-                            false);
+        const int dx = ran_c();
+        const int dy = ran_c();
+        nodes.emplace_back(x + dx, y + dy, id, ran_d());
         id++;
       }
     }
-    int x = ran(eng);
-    int y = ran(eng);
+    int x = ran();
+    int y = ran();
     for (int j = 0; j < remain; j++) {
-      nodes_.emplace_back(x + ran_c(eng), y + ran_c(eng), id, ran_d(eng),
-                          false);
+      const int dx = ran_c();
+      const int dy = ran_c();
+      nodes.emplace_back(x + dx, y + dy, id, ran_d());
       id++;
     }
   }
+  nodes_ = std::move(nodes);
 
-  std::vector<double> tmp(nodes_.size());
-  for (size_t i = 0; i < nodes_.size(); ++i) {
-    dist_mtx_.push_back(tmp);
-  }
-  for (size_t i = 0; i < nodes_.size(); ++i) {
-    for (size_t j = i; j < nodes_.size(); ++j) {
-      dist_mtx_[i][j] = sqrt(pow((nodes_[i].x_ - nodes_[j].x_), 2) +
-                             pow((nodes_[i].y_ - nodes_[j].y_), 2));
-      dist_mtx_[j][i] = dist_mtx_[i][j];
-    }
+  std::vector<double> xs;
+  std::vector<double> ys;
+  for (const auto &n : nodes_) {
+    xs.push_back(n.x_);
+    ys.push_back(n.y_);
   }
+  dist_mtx_ = dist_mtx(xs, ys, kind);
 
   int load = capacity_;
   for (int i = 0; i < nov; ++i) {
@@ -340,8 +392,11 @@ prob::prob(const int noc, const int demand_range, const int nov,
 
 void sol::print_sol(const std::string &option) const {
   double total_cost = 0;
-  for (const auto &v : vehicles_) {
+  for (veh v : vehicles_) {
     total_cost += v.cost_;
+    for (int &id : v.nodes_) {
+      id = nodes_.orig_id(id);
+    }
     if (option == "status") {
       print_veh_route(v);
     } else if (option == "route") {
@@ -353,10 +408,12 @@ void sol::print_sol(const std::string &option) const {
   std::cout << "Total solution cost: " << total_cost << '\n';
   std::cout << "Solution validity  : " << valid << '\n';
   if (!valid) {
-    for (const auto &i : nodes_) {
-      if (!i.is_routed_) {
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      if (!is_routed(i)) {
+        nd node = nodes_[i];
+        node.id_ = nodes_.orig_id(i);
         std::cout << "Unreached node: " << '\n';
-        std::cout << i << '\n';
+        std::cout << node << '\n';
       }
     }
   }
@@ -1,23 +1,65 @@
 #ifndef UTILS_HPP
 #define UTILS_HPP
 
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
 #include <string>
 #include <tuple>
 #include <vector>
+
+#include "distance.hpp"
+
 struct nd {
 public:
   int x_, y_, id_, demand_;
-  bool is_routed_;
 
-  nd(const int x = 0, const int y = 0, const int id = 0, const int demand = 0,
-     const bool is_routed = true)
-      : x_(x), y_(y), id_(id), demand_(demand), is_routed_(is_routed) {}
+  nd(const int x = 0, const int y = 0, const int id = 0, const int demand = 0)
+      : x_(x), y_(y), id_(id), demand_(demand) {}
 
   friend std::ostream &operator<<(std::ostream &os, const nd &node);
 };
 
 std::ostream &operator<<(std::ostream &os, const nd &node);
 
+// The node records of a problem, immutable once built. Copies share the
+// records, so a problem and all solutions of it hold them once. Whether a
+// node is routed is solution state, see sol::is_routed.
+class node_table {
+public:
+  node_table() : node_table(std::vector<nd>()) {}
+
+  node_table(std::vector<nd> nodes)
+      : nodes_(std::make_shared<const std::vector<nd>>(std::move(nodes))) {}
+
+  // Nodes renumbered from the problem as read (see renumber.hpp), node i
+  // having been node orig_ids[i].
+  node_table(std::vector<nd> nodes, std::vector<int> orig_ids)
+      : nodes_(std::make_shared<const std::vector<nd>>(std::move(nodes))),
+        orig_ids_(
+            std::make_shared<const std::vector<int>>(std::move(orig_ids))) {}
+
+  const nd &operator[](const size_t i) const { return (*nodes_)[i]; }
+
+  size_t size() const { return nodes_->size(); }
+
+  std::vector<nd>::const_iterator begin() const { return nodes_->begin(); }
+
+  std::vector<nd>::const_iterator end() const { return nodes_->end(); }
+
+  operator const std::vector<nd> &() const { return *nodes_; }
+
+  // The id node i had in the problem as read.
+  int orig_id(const int i) const { return orig_ids_ ? (*orig_ids_)[i] : i; }
+
+  bool renumbered() const { return orig_ids_ != nullptr; }
+
+private:
+  std::shared_ptr<const std::vector<nd>> nodes_;
+  std::shared_ptr<const std::vector<int>> orig_ids_; // null if not renumbered
+};
+
 struct veh {
 public:
   int id_, load_, capacity_;
@@ -29,7 +71,7 @@ public:
 
   friend std::ostream &operator<<(std::ostream &os, const veh &v);
 
-  void calc_cost(const std::vector<std::vector<double>> &distanceMatrix);
+  void calc_cost(const dist_mtx &distanceMatrix);
 };
 
 std::ostream &operator<<(std::ostream &os, const veh &v);
@@ -43,21 +85,28 @@ public:
   prob(const int noc = 1000, const int demand_range = 40, const int nov = 50,
        const int capacity = 800, const int grid_range = 1000,
        std::string distribution = "uniform", const int n_clusters = 5,
-       const int cluster_range = 10);
+       const int cluster_range = 10, const dist_kind kind = dist_kind::flat,
+       const uint64_t seed = std::random_device{}());
 
-  prob(const std::string &input_path, const int nov = 4);
+  // Reads a TSPLIB / CVRPLIB file; throws std::runtime_error when it
+  // cannot be read or parsed (see read_tsplib).
+  prob(const std::string &input_path, const int nov = 4,
+       const dist_kind kind = dist_kind::flat);
 
-  std::vector<nd> nodes_;
+  node_table nodes_;
   std::vector<veh> vehicles_;
-  std::vector<std::vector<double>> dist_mtx_;
+  dist_mtx dist_mtx_;
   nd depot_;
   int capacity_;
 };
 
+// A solution of a problem. The problem data (nodes_, dist_mtx_) is shared
+// with the problem and every other solution of it; what a solution owns is
+// its routes and which nodes are routed, so copies cost O(n) integers.
 class sol {
 public:
-  sol(std::vector<nd> nodes, const std::vector<veh> &vehicles,
-      std::vector<std::vector<double>> distanceMatrix);
+  sol(node_table nodes, const std::vector<veh> &vehicles,
+      dist_mtx distanceMatrix);
 
   explicit sol(const prob &p);
 
@@ -79,17 +128,44 @@ public:
 
   std::tuple<bool, nd> find_closest(const veh &v) const;
 
+  void mark_routed(int id);
+
+  bool is_routed(const int id) const {
+    return open_dem_[id] == std::numeric_limits<int>::max();
+  }
+
+  // Prints the routes in the problem's original ids.
   void print_sol(const std::string &option = "") const;
 
   std::vector<nd> get_nodes() const { return nodes_; }
 
   std::vector<veh> get_vehicles() const { return vehicles_; }
 
-  std::vector<nd> nodes_;
+  // Customers of every vehicle in visiting order, the depot left out, in
+  // the problem's original ids (see node_table::orig_id).
+  std::vector<std::vector<int>> get_routes() const;
+
+  // Replaces the routes: vehicle k gets routes[k], with loads and costs
+  // recomputed, and vehicles are added when there are more routes than
+  // vehicles. Used to warm start a search from known routes (see
+  // read_cvrplib_sol), so the ids are original ones like get_routes'.
+  // Throws std::runtime_error on an id out of range or a customer listed
+  // twice.
+  void set_routes(const std::vector<std::vector<int>> &routes);
+
+  node_table nodes_;
   std::vector<veh> vehicles_;
-  std::vector<std::vector<double>> dist_mtx_;
+  dist_mtx dist_mtx_;
   nd depot_;
   int capacity_;
+
+protected:
+  // Demand of every node, or INT_MAX once routed, scanned by find_closest.
+  // The depot starts routed, every customer open.
+  std::vector<int> open_dem_;
+  mutable std::vector<double> row_buf_;
+
+  void init_open_dem();
 };
 
 #endif // UTILS_HPP